@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2019 Nico Kluge <klugenico@mailbox.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file LICENSE, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Nico Kluge <klugenico@mailbox.org>
+ */
+
+
+#ifndef SIMPLEECS_ARCHETYPE_H
+#define SIMPLEECS_ARCHETYPE_H
+
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "Typedef.h"
+#include "PagedArray.h"
+
+namespace sEcs {
+
+    namespace Core_Intern {     // private
+
+        struct ArchetypeColumn {
+            size_t typeSize = 0;    // 0 means not stored in archetypes
+            size_t alignment = 1;
+            void (* destroyFunc)(void*) = nullptr;  // nullptr for trivially destructible types
+            void (* moveFunc)(void* destination, void* source) = nullptr;   // move constructs and destroys source
+
+            inline void move(void* destination, void* source) const {
+                if (moveFunc == nullptr)    // trivially copyable
+                    std::memcpy(destination, source, typeSize);
+                else
+                    moveFunc(destination, source);
+            }
+        };
+
+        struct ArchetypeLocation {
+            ArchetypeId archetypeId = 0;
+            uint32 row = 0;
+        };
+
+        // Components with a stricter alignment can't be archetype stored
+        struct Chunk {
+            alignas(std::max_align_t) char data[ARCHETYPE_CHUNK_SIZE];
+        };
+
+
+        // All entities with the same set of archetype stored components. The rows are packed into chunks,
+        // each chunk contains one column per component (and one for the entity indices).
+        class Archetype {
+
+        public:
+            Archetype(std::vector<ComponentId> componentIds, const std::vector<ArchetypeColumn>* columns);
+
+            ~Archetype();
+
+            uint32 add(EntityIndex entityIndex);
+
+            // Moves the last row into the removed one. Components of the removed row have to be destroyed or
+            // moved already. Returns the entity, which got the row, or INVALID.
+            EntityIndex remove(uint32 row);
+
+            inline void* get(uint32 row, ComponentId componentId) {
+                return chunks[row / chunkCapacity]->data + offsets[componentId]
+                       + (row % chunkCapacity) * (*columns)[componentId].typeSize;
+            }
+
+            inline EntityIndex getEntity(uint32 row) {
+                return reinterpret_cast<EntityIndex*>(chunks[row / chunkCapacity]->data)[row % chunkCapacity];
+            }
+
+            // The entity column is contiguous within a chunk
+            inline const EntityIndex* getEntities(uint32 row) {
+                return reinterpret_cast<EntityIndex*>(chunks[row / chunkCapacity]->data) + row % chunkCapacity;
+            }
+
+            inline bool contains(ComponentId componentId) {
+                return componentId < offsets.size() && offsets[componentId] != NO_COLUMN;
+            }
+
+            inline uint32 getAmount() {
+                return amount;
+            }
+
+            // Rows of one chunk are contiguous within each column
+            inline uint32 getChunkCapacity() {
+                return chunkCapacity;
+            }
+
+            inline const std::vector<ComponentId>& getComponentIds() {
+                return componentIds;
+            }
+
+            std::vector<ArchetypeId> addEdges;
+            std::vector<ArchetypeId> removeEdges;
+
+        private:
+            static const size_t NO_COLUMN = ~size_t(0);
+
+            std::vector<ComponentId> componentIds;
+            const std::vector<ArchetypeColumn>* columns;
+            std::vector<size_t> offsets;
+            uint32 chunkCapacity = 1;
+
+            std::vector<Chunk*> chunks;
+            uint32 amount = 0;
+
+        };
+
+
+        // An iteration over the rows, which has to know before the next entity changes its archetype
+        class RowWalker {
+
+        public:
+            virtual ~RowWalker() = default;
+
+            virtual void beforeMigration() = 0;
+
+        };
+
+
+        class ArchetypeStorage {
+
+        public:
+            ArchetypeStorage();
+
+            ArchetypeStorage(const ArchetypeStorage&) = delete;
+
+            ~ArchetypeStorage();
+
+            void registerComponent(ComponentId componentId, size_t typeSize, size_t alignment,
+                                   void(* destroyFunc)(void*), void(* moveFunc)(void*, void*));
+
+            inline bool isStored(ComponentId componentId) {
+                return componentId < columns.size() && columns[componentId].typeSize != 0;
+            }
+
+            ArchetypeId withComponent(ArchetypeId archetypeId, ComponentId componentId);
+
+            ArchetypeId withoutComponent(ArchetypeId archetypeId, ComponentId componentId);
+
+            inline ArchetypeId getArchetypeId(EntityIndex entityIndex) {
+                return entityIndex < locations.capacity() ? locations[entityIndex].archetypeId : 0;
+            }
+
+            // Moves all components, which exist in both archetypes. Components, which don't exist in the target,
+            // have to be destroyed already. New components are left uninitialized.
+            void migrate(EntityIndex entityIndex, ArchetypeId target);
+
+            // Moves entities without archetype stored components into the target at once, e.g. created ones
+            void migrate(const EntityId* entityIds, uint32 amount, ArchetypeId target);
+
+            // The walker gets notified once, before the next migration. Systems updated in parallel may walk
+            // the same storage, so the walkers are guarded.
+            inline void watch(RowWalker* walker) {
+                std::lock_guard<std::mutex> lock(walkersMutex);
+                walkers.push_back(walker);
+            }
+
+            void unwatch(RowWalker* walker);
+
+            // only defined behavior for valid requests (entity and component exists)
+            inline void* getComponent(EntityIndex entityIndex, ComponentId componentId) {
+                ArchetypeLocation& location = locations[entityIndex];
+                return archetypes[location.archetypeId]->get(location.row, componentId);
+            }
+
+            inline Archetype* getArchetype(ArchetypeId archetypeId) {
+                return archetypes[archetypeId];
+            }
+
+            inline uint32 getArchetypeAmount() {
+                return archetypes.size();
+            }
+
+        private:
+            std::vector<ArchetypeColumn> columns;
+            std::vector<Archetype*> archetypes;
+            std::map<std::vector<ComponentId>, ArchetypeId> archetypeIds;
+            PagedArray<ArchetypeLocation> locations;
+            std::vector<RowWalker*> walkers;
+            std::mutex walkersMutex;
+
+            ArchetypeId getOrCreate(const std::vector<ComponentId>& componentIds);
+
+            void notifyWalkers();
+
+        };
+
+    }      // end private
+
+}
+
+#endif //SIMPLEECS_ARCHETYPE_H
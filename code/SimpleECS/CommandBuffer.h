@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2019 Nico Kluge <klugenico@mailbox.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file LICENSE, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Nico Kluge <klugenico@mailbox.org>
+ */
+
+
+#ifndef SIMPLEECS_COMMANDBUFFER_H
+#define SIMPLEECS_COMMANDBUFFER_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "Core.h"
+
+#ifndef COMMAND_ARENA_BLOCK_SIZE
+#define COMMAND_ARENA_BLOCK_SIZE 16384
+#endif
+
+namespace sEcs {
+
+    namespace Commands {
+
+        // Records structural changes to apply them later in one pass, e.g. while iterating over entities or from
+        // other threads (one buffer per thread). The values of added components are kept in a linear arena.
+        // Entities created by the buffer get placeholder ids, which are only valid within the same buffer.
+        class CommandBuffer {
+
+        public:
+            CommandBuffer() = default;
+
+            CommandBuffer(const CommandBuffer&) = delete;
+
+            ~CommandBuffer();
+
+            EntityId createEntity();
+
+            // Returns memory for the value (nullptr for size 0), which gets moved into the component by
+            // playback. Without moveFunc the value gets copied by memcpy, without destroyFunc nothing is destroyed.
+            void* addComponent(EntityId entityId, ComponentId componentId, size_t size, size_t alignment,
+                               void(* moveFunc)(void* destination, void* source), void(* destroyFunc)(void*));
+
+            void deleteComponent(EntityId entityId, ComponentId componentId);
+
+            void eraseEntity(EntityId entityId);
+
+            // Creates the entities and changes the components of each entity at once, the last command for a
+            // component wins and erasing an entity drops all its other commands. Clears the buffer afterwards.
+            // Commands for invalid entities are ignored. Recording while playing back throws std::logic_error.
+            void playback(Core& core);
+
+            // Drops all commands and destroys the recorded values
+            void clear();
+
+            inline bool isEmpty() {
+                return commands.empty() && createdAmount == 0;
+            }
+
+        private:
+            enum class Type {
+                ADD,
+                DELETE,
+                ERASE
+            };
+
+            struct Command {
+                Type type;
+                EntityId entityId;
+                ComponentId componentId;
+                void* value;
+                size_t size;
+                void (* moveFunc)(void*, void*);
+                void (* destroyFunc)(void*);
+            };
+
+            struct Block {
+                std::unique_ptr<char[]> data;
+                size_t size;
+            };
+
+            std::vector<Command> commands;
+            uint32 createdAmount = 0;
+            bool playing = false;
+
+            std::vector<Block> blocks;
+            size_t currentBlock = 0;
+            size_t used = 0;
+
+            void* allocate(size_t size, size_t alignment);
+
+            void record(Type type, EntityId entityId, ComponentId componentId);
+
+        };
+
+    }
+
+}
+
+#endif //SIMPLEECS_COMMANDBUFFER_H
@@ -13,15 +13,20 @@
 #define SIMPLEECS_COMPONENTHANDLER_H
 
 
+#include <algorithm>
+#include <type_traits>
 #include "Core.h"
+#include "SlabAllocator.h"
 
 
 namespace sEcs {
 
+    // Components are allocated from slabs of their type, so they never move.
     class PointingComponentHandle : public sEcs::ComponentHandle {
 
     public:
-        explicit PointingComponentHandle(size_t typeSize, void(* deleteFunc)(void*));
+        explicit PointingComponentHandle(size_t typeSize, void(* destroyFunc)(void*),
+                size_t alignment = alignof(std::max_align_t));
 
         ~PointingComponentHandle() override;
 
@@ -31,10 +36,14 @@ namespace sEcs {
 
         void destroyComponentIntern(sEcs::EntityIndex entityIndex) override;
 
+        inline SlabStats getSlabStats() const {
+            return allocator.getStats();
+        }
+
     private:
-        size_t typeSize;
-        void (* deleteFunc)(void*);
-        std::vector<void*> components;
+        void (* destroyFunc)(void*);
+        SlabAllocator allocator;
+        Core_Intern::PagedArray<void*> components;
 
     };
 
@@ -53,7 +62,147 @@ namespace sEcs {
     private:
         size_t typeSize;
         void (* destroyFunc)(void*);
-        std::vector<char> data;
+        std::vector<std::unique_ptr<char[]>> pages;    // ENTITY_PAGE_SIZE components each, so they never move
+
+    };
+
+
+    // Stores the values like the ValuedComponentHandle, but typed. get() reaches the components without virtual
+    // calls, so the compiler can inline the access. Destroying trivially destructible components does nothing.
+    template<typename T>
+    class TypedComponentHandle : public sEcs::ComponentHandle {
+
+    public:
+        TypedComponentHandle() {
+            trivialDestroy = std::is_trivially_destructible<T>::value;
+            typed = true;
+        }
+
+        // The components of living entities are destroyed with the handle
+        ~TypedComponentHandle() override {
+            for (sEcs::EntityIndex i = 0; !trivialDestroy && i < living.capacity(); i++)
+                if (living[i])
+                    get(i)->~T();
+        }
+
+        inline T* get(sEcs::EntityIndex entityIndex) {
+            return reinterpret_cast<T*>(&slots[entityIndex]);
+        }
+
+        void* getComponent(sEcs::EntityIndex entityIndex) override {
+            return get(entityIndex);
+        }
+
+        void* createComponent(sEcs::EntityIndex entityIndex) override {
+            slots.ensure(entityIndex);
+            if (!trivialDestroy) {
+                living.ensure(entityIndex);
+                living[entityIndex] = true;
+            }
+            return get(entityIndex);
+        }
+
+        void createComponents(const sEcs::EntityId* entityIds, sEcs::uint32 amount) override {
+            sEcs::EntityIndex maxIndex = 0;
+            for (sEcs::uint32 i = 0; i < amount; i++)
+                maxIndex = std::max(maxIndex, entityIds[i].index);
+            slots.ensure(maxIndex);
+            if (!trivialDestroy) {
+                living.ensure(maxIndex);
+                for (sEcs::uint32 i = 0; i < amount; i++)
+                    living[entityIds[i].index] = true;
+            }
+        }
+
+        void destroyComponentIntern(sEcs::EntityIndex entityIndex) override {
+            get(entityIndex)->~T();
+            living[entityIndex] = false;
+        }
+
+    private:
+        Core_Intern::PagedArray<typename std::aligned_storage<sizeof(T), alignof(T)>::type> slots;
+        Core_Intern::PagedArray<bool> living;   // only kept for components, which need destruction
+
+    };
+
+
+    // Packs the components densely, so memory and iteration are proportional to the amount of components.
+    // Destroying a component moves the last one into its place, so pointers are only valid until the next change.
+    class SparseSetComponentHandle : public sEcs::ComponentHandle {
+
+    public:
+        explicit SparseSetComponentHandle(size_t typeSize, void(* destroyFunc)(void*),
+                void(* moveFunc)(void* destination, void* source));
+
+        ~SparseSetComponentHandle() override;
+
+        void* getComponent(sEcs::EntityIndex entityIndex) override;
+
+        void* createComponent(sEcs::EntityIndex entityIndex) override;
+
+        void destroyComponentIntern(sEcs::EntityIndex entityIndex) override;
+
+        inline sEcs::uint32 getAmount() {
+            return entityIndices.size();
+        }
+
+        inline sEcs::EntityIndex getEntityIndex(sEcs::uint32 denseIndex) {
+            return entityIndices[denseIndex];
+        }
+
+        inline void* getDenseComponent(sEcs::uint32 denseIndex) {
+            return data + denseIndex * typeSize;
+        }
+
+    private:
+        size_t typeSize;
+        void (* destroyFunc)(void*);
+        void (* moveFunc)(void*, void*);
+
+        Core_Intern::PagedArray<sEcs::InternIndex> sparse;     // dense index + 1 for every entity, 0 if not existing
+        std::vector<sEcs::EntityIndex> entityIndices;
+        char* data = nullptr;
+        sEcs::uint32 capacity = 0;
+
+    };
+
+
+    // Storage-less handle for tags, all components share the same dummy address.
+    class TagComponentHandle : public sEcs::ComponentHandle {
+
+    public:
+        TagComponentHandle() {
+            trivialDestroy = true;
+        }
+
+        void* getComponent(sEcs::EntityIndex entityIndex) override;
+
+        void* createComponent(sEcs::EntityIndex entityIndex) override;
+
+        void destroyComponentIntern(sEcs::EntityIndex entityIndex) override;
+
+    private:
+        alignas(std::max_align_t) char tag = 0;
+
+    };
+
+
+    class ArchetypeComponentHandle : public sEcs::ComponentHandle {
+
+    public:
+        explicit ArchetypeComponentHandle(
+                Core_Intern::ArchetypeStorage* storage, sEcs::ComponentId componentId, void(* destroyFunc)(void*));
+
+        void* getComponent(sEcs::EntityIndex entityIndex) override;
+
+        void* createComponent(sEcs::EntityIndex entityIndex) override;
+
+        void destroyComponentIntern(sEcs::EntityIndex entityIndex) override;
+
+    private:
+        Core_Intern::ArchetypeStorage* storage;
+        sEcs::ComponentId componentId;
+        void (* destroyFunc)(void*);
 
     };
 
@@ -12,8 +12,13 @@
 #ifndef SIMPLE_ECS_CORE_H
 #define SIMPLE_ECS_CORE_H
 
+#include <atomic>
+#include <functional>
+#include <memory>
 #include "Typedef.h"
 #include "EventHandler.h"
+#include "Archetype.h"
+#include "PagedArray.h"
 
 namespace sEcs {
 
@@ -37,6 +42,13 @@ namespace sEcs {
             EntityId entityId;
         };
 
+        // Replaces the deleted and added event, if a component gets overwritten in place (see ComponentTraits)
+        struct ComponentReplacedEvent {
+            explicit ComponentReplacedEvent(const EntityId& entityId) : entityId(entityId) {}
+
+            EntityId entityId;
+        };
+
         struct EntityCreatedEvent {
             explicit EntityCreatedEvent(const EntityId& entityId) : entityId(entityId) {}
 
@@ -49,19 +61,46 @@ namespace sEcs {
             EntityId entityId;
         };
 
+        // Emitted once by createEntities for all created entities. The ids are only valid while receiving.
+        struct EntitiesCreatedEvent {
+            EntitiesCreatedEvent(const EntityId* entityIds, uint32 amount) : entityIds(entityIds), amount(amount) {}
+
+            const EntityId* entityIds;
+            uint32 amount;
+        };
+
+        // Emitted once by eraseEntities before the entities get erased. The ids are only valid while receiving.
+        struct EntitiesErasedEvent {
+            EntitiesErasedEvent(const EntityId* entityIds, uint32 amount) : entityIds(entityIds), amount(amount) {}
+
+            const EntityId* entityIds;
+            uint32 amount;
+        };
+
     }
 
 #endif
 
     namespace Core_Intern {     // private
 
+        inline uint32 countTrailingZeros(uint64 word) {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctzll(word);
+#else
+            uint32 count = 0;
+            for (; (word & 1u) == 0; word >>= 1u)
+                count++;
+            return count;
+#endif
+        }
+
+        // Fixed size set of bits stored in 64 bit words. The word count is a compile time constant, so the loops
+        // get unrolled and vectorized by the compiler (SSE2/AVX2 for 128/256 bit and wider masks).
         template<size_t size>
         struct BitSet {
 
         public:
-            BitSet() {
-                arraySize = (size / BITSET_TYPE_SIZE) + 1;
-            }
+            static const size_t WORDS = (size / BITSET_TYPE_SIZE) + 1;
 
             inline void set(std::vector<uint32> *bits) {
                 for (uint32 position : *bits)
@@ -73,7 +112,7 @@ namespace sEcs {
             }
 
             inline void unset(uint32 bit) {
-                bitset[bit / BITSET_TYPE_SIZE] &= ~(1u << (bit % BITSET_TYPE_SIZE));
+                bitset[bit / BITSET_TYPE_SIZE] &= ~(BITSET_TYPE(1u) << (bit % BITSET_TYPE_SIZE));
             }
 
             inline void reset() {
@@ -81,35 +120,64 @@ namespace sEcs {
                     bitrow = 0;
             }
 
-            inline bool isSet(uint32 bit) {
-                return ((bitset[bit / BITSET_TYPE_SIZE] >> (bit % BITSET_TYPE_SIZE)) & BITSET_TYPE(1u)) == 1u;
+            inline bool isSet(uint32 bit) const {
+                return (bitset[bit / BITSET_TYPE_SIZE] >> (bit % BITSET_TYPE_SIZE)) & BITSET_TYPE(1u);
             }
 
-            inline bool contains(BitSet *other) {
-                for (size_t i = 0; i < arraySize; ++i)
-                    if ((other->bitset[i] & ~bitset[i]) > 0u)
-                        return false;
-                return true;
+            // branch free, all words are checked
+            inline bool contains(const BitSet *other) const {
+                BITSET_TYPE missing = 0;
+                for (size_t i = 0; i < WORDS; ++i)
+                    missing |= other->bitset[i] & ~bitset[i];
+                return missing == 0;
+            }
+
+            inline void unite(const BitSet *other) {
+                for (size_t i = 0; i < WORDS; ++i)
+                    bitset[i] |= other->bitset[i];
+            }
+
+            inline bool intersects(const BitSet *other) const {
+                BITSET_TYPE common = 0;
+                for (size_t i = 0; i < WORDS; ++i)
+                    common |= other->bitset[i] & bitset[i];
+                return common != 0;
+            }
+
+            // Calls func(bit) for every bit, which is set in only one of both sets
+            template<typename Func>
+            inline void forEachDifference(const BitSet *other, Func func) const {
+                for (size_t i = 0; i < WORDS; ++i) {
+                    BITSET_TYPE difference = bitset[i] ^ other->bitset[i];
+                    while (difference != 0) {
+                        func(static_cast<uint32>(i * BITSET_TYPE_SIZE + countTrailingZeros(difference)));
+                        difference &= difference - 1;   // clear lowest bit
+                    }
+                }
             }
 
         private:
-            size_t arraySize;
-            BITSET_TYPE bitset[(size / BITSET_TYPE_SIZE) + 1]{};
+            BITSET_TYPE bitset[WORDS]{};
 
         };
 
         typedef BitSet<MAX_COMPONENT_AMOUNT> ComponentBitset;
 
+        // Inline, because pages of states get initialized and created entities set them in bulk
         class EntityState {
 
         public:
-            explicit EntityState();
+            explicit EntityState() : version(INVALID) {}
 
-            explicit EntityState(EntityVersion version);
+            explicit EntityState(EntityVersion version) : version(version) {}
 
-            EntityId id(EntityIndex index) const;
+            inline EntityId id(EntityIndex index) const {
+                return {version, index};
+            }
 
-            ComponentBitset *getComponentMask();
+            inline ComponentBitset *getComponentMask() {
+                return &componentMask;
+            }
 
             void reset();
 
@@ -122,17 +190,23 @@ namespace sEcs {
         class EntitySet {
 
         public:
-            explicit EntitySet(std::vector<ComponentId> componentIds);
+            EntitySet(std::vector<ComponentId> componentIds, std::vector<ComponentId> excludedIds);
 
             inline void dumbAddIfMember(EntityId entityId, ComponentBitset *bitset) {
-                if (bitset->contains(&mask))
+                if (isMember(bitset))
                     add(entityId.index);
             }
 
+            // all components of the mask and none of the excluded ones
+            inline bool isMember(ComponentBitset *bitset) {
+                return bitset->contains(&mask) && !bitset->intersects(&excludeMask);
+            }
+
             void updateMembership(EntityIndex entityIndex, ComponentBitset *previous, ComponentBitset *recent);
 
+            // Holes only exist while entities got removed during an iteration
             inline InternIndex next(InternIndex internIndex) {
-                int entitiesSize = entities.size();
+                InternIndex entitiesSize = entities.size();
                 do {
                     if (++internIndex >= entitiesSize) {
                         return INVALID; // End of Array
@@ -145,20 +219,64 @@ namespace sEcs {
                 return entities[internIndex];
             }
 
+            // One past the last intern index, including holes
+            inline InternIndex getEnd() {
+                return entities.size();
+            }
+
             void add(EntityIndex entityIndex);
 
-            bool concern(std::vector<ComponentId> *vector);
+            // Appends entities, which are no members yet
+            void add(const EntityId* entityIds, uint32 amount);
+
+            inline bool contains(EntityIndex entityIndex) {
+                return entityIndex < internIndices.capacity() && internIndices[entityIndex] != INVALID;
+            }
+
+            // Removes the members of the entities. If these are all members, the set gets cleared at once.
+            void remove(const EntityIndex* entityIndices, uint32 amount);
+
+            bool concern(std::vector<ComponentId> *vector, std::vector<ComponentId> *excluded);
+
+            inline uint32 getAmount() {
+                return amount;
+            }
+
+            // While at least one iteration is running, removed entities leave a hole instead of being replaced by
+            // the last entity, so no entity gets skipped or visited twice. The holes get filled, when the last
+            // running iteration ends. Entities added meanwhile are visited in the same iteration.
+            // Systems reading the same set may iterate concurrently, so the count is atomic and only the last
+            // ending iteration fills the holes.
+            inline void beginIteration() {
+                runningIterations++;
+            }
 
-            uint32 getVagueAmount();
+            void endIteration();
+
+            // Returns false, if the set got already visited with this stamp
+            inline bool visit(uint64 stamp) {
+                if (visitStamp == stamp)
+                    return false;
+                visitStamp = stamp;
+                return true;
+            }
 
         private:
             ComponentBitset mask;
+            ComponentBitset excludeMask;
             std::vector<ComponentId> componentIds;
+            std::vector<ComponentId> excludedIds;
+
+            std::vector<EntityIndex> entities;     // dense, the first element is always INVALID
+            uint32 amount = 0;
+
+            PagedArray<InternIndex> internIndices;  // We need this List to avoid double insertions
+            std::vector<InternIndex> holes;
+            std::atomic<uint32> runningIterations{0};
 
-            std::vector<EntityIndex> entities;
+            void remove(EntityIndex entityIndex);
 
-            std::vector<InternIndex> internIndices;  // We need this List to avoid double insertions
-            std::vector<InternIndex> freeInternIndices;
+            uint64 visitStamp = 0;
 
         };
 
@@ -166,24 +284,244 @@ namespace sEcs {
         class SetIterator {
 
         public:
-            explicit SetIterator(EntitySet *entitySet) :
+            virtual ~SetIterator() = default;
+
+            virtual EntityIndex next() = 0;
+
+            virtual uint32 getAmount() = 0;
+
+            // Passes processing the entities concurrently address them by positions in [0, beginPass()), some positions
+            // may be INVALID. Entities must not be added or removed until endPass(). By default the entities get
+            // collected with next().
+            virtual uint32 beginPass();
+
+            virtual inline EntityIndex at(uint32 position) {
+                return passed[position];
+            }
+
+            virtual void endPass();
+
+            // Stops an iteration with next() before it reached INVALID, the next call begins again
+            virtual void reset() {}
+
+        private:
+            std::vector<EntityIndex> passed;
+
+        };
+
+
+        // Resets the iterator when leaving the scope, also if a callback throws or a loop breaks
+        class IterationGuard {
+
+        public:
+            explicit IterationGuard(SetIterator* iterator) : iterator(iterator) {}
+            IterationGuard(const IterationGuard&) = delete;
+            IterationGuard& operator=(const IterationGuard&) = delete;
+
+            ~IterationGuard() {
+                iterator->reset();
+            }
+
+        private:
+            SetIterator* iterator;
+
+        };
+
+
+        // Begins a pass and ends it when leaving the scope
+        class PassGuard {
+
+        public:
+            explicit PassGuard(SetIterator* iterator) : iterator(iterator), end(iterator->beginPass()) {}
+            PassGuard(const PassGuard&) = delete;
+            PassGuard& operator=(const PassGuard&) = delete;
+
+            ~PassGuard() {
+                iterator->endPass();
+            }
+
+            inline uint32 getEnd() const {
+                return end;
+            }
+
+        private:
+            SetIterator* iterator;
+            uint32 end;
+
+        };
+
+
+        class EntitySetIterator : public SetIterator {
+
+        public:
+            explicit EntitySetIterator(EntitySet *entitySet) :
                     entitySet(entitySet) {}
 
-            inline EntityIndex next() {
+            ~EntitySetIterator() override {
+                if (iterator != INVALID)    // destroyed within a pass
+                    entitySet->endIteration();
+            }
+
+            inline EntityIndex next() override {
+                if (iterator == INVALID)
+                    entitySet->beginIteration();
                 iterator = entitySet->next(iterator);
+                if (iterator == INVALID)
+                    entitySet->endIteration();
                 return entitySet->getIndex(iterator);
             }
 
+            uint32 getAmount() override {
+                return entitySet->getAmount();
+            }
+
             inline EntitySet* getEntitySet() {
                 return entitySet;
             }
 
+            // Addresses the dense list of the set directly
+            uint32 beginPass() override;
+
+            inline EntityIndex at(uint32 position) override {
+                return entitySet->getIndex(position + 1);
+            }
+
+            void endPass() override;
+
+            void reset() override;
+
         private:
             EntitySet *entitySet;
             InternIndex iterator = 0;
 
         };
 
+
+        // Walks linearly through the entity columns of the chunks of all archetypes containing the components.
+        // Changing components moves entities between archetypes and refills removed rows, so before the first entity
+        // changes its archetype during a pass, the iterator takes the entities of the remaining rows and goes on with
+        // them. Entities, which lose the components meanwhile, are left out and entities, which get them meanwhile,
+        // are visited by the next pass. So no entity gets skipped or visited twice.
+        class ArchetypeSetIterator : public SetIterator, public RowWalker {
+
+        public:
+            ArchetypeSetIterator(ArchetypeStorage *storage, std::vector<ComponentId> componentIds,
+                                 std::vector<ComponentId> excludedIds);
+
+            ~ArchetypeSetIterator() override {
+                reset();
+            }
+
+            EntityIndex next() override;
+
+            uint32 getAmount() override;
+
+            inline ArchetypeStorage* getStorage() {
+                return storage;
+            }
+
+            // all archetypes containing the components
+            const std::vector<ArchetypeId>& getMatching();
+
+            void reset() override;
+
+            void beforeMigration() override;
+
+        private:
+            ArchetypeStorage *storage;
+            std::vector<ComponentId> componentIds;
+            std::vector<ComponentId> excludedIds;
+
+            std::vector<ArchetypeId> matching;
+            uint32 checkedArchetypes = 0;
+
+            std::vector<bool> matchingIds;      // by ArchetypeId
+
+            bool running = false;
+            bool snapshot = false;
+
+            // the walked chunk
+            uint32 matchingPosition = 0;
+            uint32 row = 0;
+            const EntityIndex* chunkEntities = nullptr;
+            uint32 chunkAmount = 0;
+
+            uint32 position = 0;
+            std::vector<EntityIndex> passing;   // the remaining entities, when the first one changed its archetype
+
+            void updateMatching();
+
+            bool nextChunk();
+
+        };
+
+
+        struct ComponentTicks {
+            uint32 added = 0;
+            uint32 changed = 0;
+        };
+
+        struct ComponentRemoval {
+            EntityId entityId;
+            uint32 tick;
+        };
+
+        // Change ticks of the components of one type and the removals of these components
+        class ChangeTracking {
+
+        public:
+            inline void add(EntityIndex entityIndex, uint32 tick) {
+                ticks.ensure(entityIndex);
+                ticks[entityIndex].added = tick;
+                ticks[entityIndex].changed = tick;
+            }
+
+            // only defined behavior for existing components
+            inline void change(EntityIndex entityIndex, uint32 tick) {
+                ticks[entityIndex].changed = tick;
+            }
+
+            inline void remove(EntityId entityId, uint32 tick) {
+                removals.push_back({entityId, tick});
+            }
+
+            // only defined behavior for existing components
+            inline const ComponentTicks& get(EntityIndex entityIndex) {
+                return ticks[entityIndex];
+            }
+
+            // ordered by their ticks
+            inline const std::vector<ComponentRemoval>& getRemovals() {
+                return removals;
+            }
+
+            inline void ensure(EntityIndex entityIndex) {
+                ticks.ensure(entityIndex);
+            }
+
+            // Forgets the removals before the tick
+            void prune(uint32 tick);
+
+        private:
+            PagedArray<ComponentTicks> ticks;
+            std::vector<ComponentRemoval> removals;
+
+        };
+
+
+        typedef std::function<void(const EntityId* entityIds, uint32 amount)> ObserverCallback;
+
+        // Collects the entities, which got or lost a component type, until they get delivered at once
+        struct Observer {
+            ComponentId componentId;
+            ObserverCallback onAdded;      // may be empty
+            ObserverCallback onRemoved;    // may be empty
+            std::vector<EntityId> added;
+            std::vector<EntityId> removed;
+            std::vector<EntityId> deliveredAdded;      // swapped with added while delivering, keeps the capacity
+            std::vector<EntityId> deliveredRemoved;
+        };
+
     }      // end private
 
 
@@ -191,10 +529,21 @@ namespace sEcs {
     struct ComponentEventInfo {
         EventId addEventId = 0;
         EventId deleteEventId = 0;
+        EventId replaceEventId = 0;
+        bool replaceEvents = false;     // emit one replaced event instead of deleted and added on overwrites
+        bool enabled = true;            // emit the events of the component at all
     };
 #endif
 
 
+    // Recorded at registration. Components of trivially copyable types get overwritten in place,
+    // if they are added to an entity which has one already.
+    struct ComponentTraits {
+        bool triviallyDestructible = false;
+        bool triviallyCopyable = false;
+    };
+
+
     class ComponentHandle {
 
     public:
@@ -202,7 +551,25 @@ namespace sEcs {
 
         // only defined behavior for valid requests (entity and component exists)
         void destroyComponent(sEcs::EntityId entityId, sEcs::EntityIndex entityIndex) {
-            destroyComponentIntern(entityIndex);
+            if (!trivialDestroy)
+                destroyComponentIntern(entityIndex);
+        }
+
+        // only defined behavior for valid requests (entities and components exist)
+        void destroyComponents(const sEcs::EntityIndex* entityIndices, sEcs::uint32 amount) {
+            if (!trivialDestroy)
+                for (sEcs::uint32 i = 0; i < amount; i++)
+                    destroyComponentIntern(entityIndices[i]);
+        }
+
+        // True, if destroying a component does nothing, e.g. for trivially destructible values
+        inline bool destroysNothing() {
+            return trivialDestroy;
+        }
+
+        // True for a TypedComponentHandle of the component type
+        inline bool isTyped() {
+            return typed;
         }
 
         // only defined behavior for valid requests (entity and component exists)
@@ -211,6 +578,16 @@ namespace sEcs {
         // only defined behavior for valid requests (entity exists and component not)
         virtual void* createComponent(sEcs::EntityIndex entityIndex) = 0;
 
+        // only defined behavior for valid requests (entities exist and components not)
+        virtual void createComponents(const sEcs::EntityId* entityIds, sEcs::uint32 amount) {
+            for (sEcs::uint32 i = 0; i < amount; i++)
+                createComponent(entityIds[i].index);
+        }
+
+        ComponentTraits& getTraits() {
+            return traits;
+        }
+
 #if USE_ECS_EVENTS == 1
 
         ComponentEventInfo& getComponentEventInfo() {
@@ -221,6 +598,11 @@ namespace sEcs {
         ComponentEventInfo componentEventInfo;
 #endif
 
+    protected:
+        ComponentTraits traits;
+        bool trivialDestroy = false;    // set by handles, which destroy nothing but the value itself
+        bool typed = false;
+
     private:
         // only defined behavior for valid requests (entity and component exists)
         virtual void destroyComponentIntern(sEcs::EntityIndex entityIndex) = 0;
@@ -234,46 +616,179 @@ namespace sEcs {
 
         Core(const Core&) = delete;
 
-        explicit Core();
+        // The maximum amount of entities is a soft limit, memory is allocated on demand.
+        explicit Core(uint32 maxEntityAmount = MAX_ENTITY_AMOUNT);
 
         ~Core();
 
+        // Returns an invalid EntityId, if the maximum amount of entities is reached.
         EntityId createEntity();
 
+        // Creates up to amount entities with the same components at once and writes their ids to entityIds.
+        // The components are left uninitialized for the caller. Every related set gets all entities appended at
+        // once. Per entity events are only emitted to existing listeners, EntitiesCreatedEvent is emitted once.
+        // Returns the amount of created entities, which is smaller if the maximum amount of entities is reached.
+        // Passing a component twice throws std::invalid_argument.
+        uint32 createEntities(uint32 amount, EntityId* entityIds, const ComponentId* ids = nullptr, size_t idsAmount = 0);
+
         bool isValid(EntityId entityId);
 
         bool eraseEntity(EntityId entityId);
 
-        ComponentId registerComponent(ComponentHandle* ch);
+        // Erases the valid ones of the entities at once: The components get destroyed per storage, every related set
+        // is updated once and EntitiesErasedEvent is emitted once. Per entity events are only emitted to existing
+        // listeners. Returns the amount of erased entities.
+        uint32 eraseEntities(const EntityId* entityIds, uint32 amount);
+
+        // Erases all entities of the SetIterator at once, see eraseEntities
+        uint32 clearQuery(SetIteratorId setIteratorId);
+
+        uint32 clearQuery(Core_Intern::SetIterator& setIterator);
+
+        ComponentId registerComponent(ComponentHandle* ch, ComponentTraits traits = ComponentTraits());
+
+        // Components of this type share chunks with the other archetype stored components of an entity.
+        // Pointers to them are only stable until the next structural change of the entity.
+        // Without destroyFunc nothing gets destroyed and without moveFunc components get moved by memcpy.
+        ComponentId registerArchetypeComponent(size_t typeSize, size_t alignment,
+                void(* destroyFunc)(void*), void(* moveFunc)(void* destination, void* source),
+                ComponentTraits traits = ComponentTraits());
+
+        // Tags have no storage, they only exist as bit in the entity's mask. Their component events are emitted
+        // like the ones of other components, overwriting a tag emits replace events.
+        ComponentId registerTagComponent();
+
+        inline bool isTag(ComponentId componentId) {
+            return tags.isSet(componentId);
+        }
+
+        inline bool isArchetypeStored(ComponentId componentId) {
+            return archetypes.isStored(componentId);
+        }
 
         void* addComponent(EntityId entityId, ComponentId componentId);
 
-        // OptimizeAble
+        // Added components are left uninitialized for the caller, see changeComponents
         bool activateComponents(EntityId entityId, const ComponentId* ids, size_t idsAmount);
 
+        // Adds and deletes components (disjoint ids) with a single update of the sets. Added components are left
+        // uninitialized for the caller, except existing trivially copyable ones, which get overwritten in place.
+        bool changeComponents(EntityId entityId, const ComponentId* addedIds, size_t addedAmount,
+                              const ComponentId* deletedIds, size_t deletedAmount);
+
         void* getComponent(EntityId entityId, ComponentId componentId);
 
+        // only defined behavior for valid indices (see getIndex)
+        inline bool hasComponent(EntityIndex entityIndex, ComponentId componentId) {
+            return entities[entityIndex].componentMask.isSet(componentId);
+        }
+
+        inline ComponentHandle* getComponentHandle(ComponentId componentId) {
+            return componentHandles[componentId];
+        }
+
         bool deleteComponent(EntityId entityId, ComponentId componentId);
 
+        // Components of tracked types get the current change tick, when they are added or marked as changed, and
+        // their removals are kept until pruneRemovals. Untracked types don't pay for it.
+        void trackChanges(ComponentId componentId);
+
+        // nullptr for untracked component types
+        inline Core_Intern::ChangeTracking* getChangeTracking(ComponentId componentId) {
+            return changeTracking[componentId].get();
+        }
+
+        inline uint32 getChangeTick() {
+            return changeTick.load(std::memory_order_relaxed);
+        }
+
+        // Starts a new tick and returns it. A query passes the changes after the tick its previous pass ended on.
+        inline uint32 advanceChangeTick() {
+            return changeTick.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        // only defined behavior for valid indices and existing components
+        inline void markChanged(EntityIndex entityIndex, ComponentId componentId) {
+            Core_Intern::ChangeTracking* tracking = changeTracking[componentId].get();
+            if (tracking != nullptr)
+                tracking->change(entityIndex, getChangeTick());
+        }
+
+        // Forgets the removals of all tracked components before the tick
+        void pruneRemovals(uint32 tick);
+
+        // Collects the entities, which get or lose the component, instead of calling a listener per change. They
+        // are handed over per observer by deliverObservations. Components without observers don't pay for it.
+        ObserverId observe(ComponentId componentId, Core_Intern::ObserverCallback onAdded,
+                           Core_Intern::ObserverCallback onRemoved = nullptr);
+
+        // Collected entities, which aren't delivered yet, get dropped
+        void unobserve(ObserverId observerId);
+
+        // Hands each observer the entities collected since the last delivery, the added ones first. An entity is
+        // in both, if it got and lost the component meanwhile. Changes made by the callbacks get delivered next time.
+        void deliverObservations();
+
 #if USE_ECS_EVENTS == 1
 
         EventId componentDeletedEventId(ComponentId componentId);
 
         EventId componentAddedEventId(ComponentId componentId);
 
+        EventId componentReplacedEventId(ComponentId componentId);
+
+        // Only affects components with trivially copyable traits
+        void setReplaceEvents(ComponentId componentId, bool replaceEvents);
+
+        // Switches the added, deleted and replaced events of the component on or off. Events without listeners
+        // aren't constructed anyway.
+        void setComponentEvents(ComponentId componentId, bool enabled);
+
         EventId entityCreatedEventId();
 
         EventId entityErasedEventId();
 
+        EventId entitiesCreatedEventId();
+
+        EventId entitiesErasedEventId();
+
+        // Delegates, which only receive the component events (added, deleted, replaced) and the erased event of one
+        // entity. They are looked up by the EntityIndex, so other entities don't touch them, and get unsubscribed
+        // when the entity is erased. Returns an empty subscription for invalid entities.
+        Events::Subscription subscribeEntityEvent(EventId eventId, EntityId entityId, Events::Delegate delegate);
+
+        // Only receives the events of entities with all components and none of the excluded ones. Deleted
+        // components still count and added ones already do. Only for the component events (added, deleted,
+        // replaced) and the erased event, other ids throw std::invalid_argument.
+        Events::Subscription subscribeEntityEvent(EventId eventId, std::vector<ComponentId> componentIds,
+                                                  std::vector<ComponentId> excludedIds, Events::Delegate delegate);
+
+        using Events::EventHandler::unsubscribeEvent;
+
+        // Also releases the filter of query subscriptions
+        void unsubscribeEvent(Events::Subscription subscription);
+
 #endif
 
-        SetIteratorId createSetIterator(std::vector<ComponentId> componentIds);
+        // Iterates over all entities with all components and none of the excluded components
+        SetIteratorId createSetIterator(std::vector<ComponentId> componentIds,
+                                        std::vector<ComponentId> excludedIds = std::vector<ComponentId>());
+
+        // A SetIterator owned by the caller, e.g. for views
+        std::unique_ptr<Core_Intern::SetIterator> makeSetIterator(std::vector<ComponentId> componentIds,
+                std::vector<ComponentId> excludedIds = std::vector<ComponentId>());
 
         inline EntityId nextEntity(SetIteratorId setIteratorId) {
             EntityIndex nextIndex = setIterators[setIteratorId]->next();
             return entities[nextIndex].id(nextIndex);
         }
 
+        // A loop stopping before nextEntity returned INVALID has to reset the iterator, otherwise the set stays in
+        // iteration and the next loop continues where this one stopped
+        inline void resetSetIterator(SetIteratorId setIteratorId) {
+            setIterators[setIteratorId]->reset();
+        }
+
         uint32 getEntityAmount(SetIteratorId setIteratorId);
 
         uint32 getEntityAmount(std::vector<ComponentId>& componentIds);
@@ -292,26 +807,113 @@ namespace sEcs {
 
         EntityId getIdFromIndex(EntityIndex index);
 
+        inline uint32 getMaxEntityAmount() {
+            return maxEntityAmount;
+        }
+
+        inline void setMaxEntityAmount(uint32 amount) {
+            maxEntityAmount = amount;
+        }
+
 
     private:
         EntityIndex lastEntityIndex = 0;
+        uint32 maxEntityAmount;
 
 #if USE_ECS_EVENTS == 1
         uint32 entityCreatedEventId_;
         uint32 entityErasedEventId_;
+        uint32 entitiesCreatedEventId_;
+        uint32 entitiesErasedEventId_;
 #endif
 
-        std::vector<Core_Intern::EntityState> entities;
+        Core_Intern::PagedArray<Core_Intern::EntityState> entities;
         std::vector<EntityIndex> freeEntityIndices;
 
         std::vector<ComponentHandle *> componentHandles;
 
+        Core_Intern::ArchetypeStorage archetypes;
+        std::vector<ComponentId> archetypeComponentIds;
+
+        Core_Intern::ComponentBitset tags;
+
         std::vector<Core_Intern::EntitySet *> entitySets;
+        std::vector<std::vector<Core_Intern::EntitySet *>> componentSets;  // EntitySets by their (excluded) components
+        uint64 membershipStamp = 0;
         std::vector<Core_Intern::SetIterator *> setIterators;
 
+        std::vector<std::unique_ptr<Core_Intern::ChangeTracking>> changeTracking;     // by component
+        std::atomic<uint32> changeTick{1};
+
+        std::vector<std::unique_ptr<Core_Intern::Observer>> observers;      // by ObserverId, nullptr if removed
+        std::vector<std::vector<Core_Intern::Observer*>> componentObservers;    // by component
+        std::vector<std::unique_ptr<Core_Intern::Observer>> retiredObservers;  // removed while delivering
+        bool delivering = false;
+
+#if USE_ECS_EVENTS == 1
+        // The context of a delegate, which filters the events by the components of their entity
+        struct QueryDelegate {
+            Core* core;
+            Core_Intern::ComponentBitset mask;
+            Core_Intern::ComponentBitset excludeMask;
+            Events::Delegate delegate;
+            Events::Subscription subscription;
+        };
+
+        std::vector<std::unique_ptr<QueryDelegate>> queryDelegates;
+
+        static void emitFiltered(void* context, const void* event);
+
+        // The events starting with the EntityId of a single entity, which emitFiltered can filter
+        bool isEntityEvent(EventId eventId);
+#endif
+
+        // Components, which are tracked or observed. Only these pay for recording additions and removals.
+        Core_Intern::ComponentBitset watched;
+        std::vector<ComponentId> watchedComponentIds;
+
+        inline void recordAdded(EntityId entityId, ComponentId componentId) {
+            if (watched.isSet(componentId))
+                recordWatched(&entityId, 1, componentId, true);
+        }
+
+        inline void recordRemoved(EntityId entityId, ComponentId componentId) {
+            if (watched.isSet(componentId))
+                recordWatched(&entityId, 1, componentId, false);
+        }
+
+        void recordWatched(const EntityId* entityIds, uint32 amount, ComponentId componentId, bool added);
+
+        void watch(ComponentId componentId);
+
+        void finishDelivery(ObserverId amount);
+
         void updateAllMemberships(
                 EntityId entityId, Core_Intern::ComponentBitset *previous, Core_Intern::ComponentBitset *recent);
 
+        void updateArchetype(
+                EntityIndex entityIndex, Core_Intern::ComponentBitset *previous, Core_Intern::ComponentBitset *recent);
+
+#if USE_ECS_EVENTS == 1
+        void emitReplaceEvents(EntityId entityId, ComponentHandle* ch);
+
+        inline void emitAddedEvent(EntityId entityId, ComponentHandle* ch) {
+            ComponentEventInfo& info = ch->getComponentEventInfo();
+            if (info.enabled && hasListeners(info.addEventId)) {
+                auto event = Events::ComponentAddedEvent(entityId);
+                emitEvent(info.addEventId, entityId.index, &event);
+            }
+        }
+
+        inline void emitDeletedEvent(EntityId entityId, ComponentHandle* ch) {
+            ComponentEventInfo& info = ch->getComponentEventInfo();
+            if (info.enabled && hasListeners(info.deleteEventId)) {
+                auto event = Events::ComponentDeletedEvent(entityId);
+                emitEvent(info.deleteEventId, entityId.index, &event);
+            }
+        }
+#endif
+
     };
 
 }
@@ -13,8 +13,10 @@
 #define SIMPLEECS_ECSMANAGER_H
 
 #include <memory>
+#include <stdexcept>
 #include "Core.h"
 #include "Register.h"
+#include "JobSystem.h"
 
 
 namespace sEcs {
@@ -36,11 +38,51 @@ namespace sEcs {
         };
     }
 
+    // Components a system reads and writes. In parallel updates systems run concurrently, if neither writes a
+    // component the other one accesses. Systems without declared access and exclusive systems run alone.
+    struct SystemAccess {
+        bool declared = false;
+        bool exclusive = false;
+        Core_Intern::ComponentBitset reads;
+        Core_Intern::ComponentBitset writes;
+
+        inline bool conflicts(const SystemAccess& other) const {
+            return !declared || !other.declared || exclusive || other.exclusive || writes.intersects(&other.reads)
+                   || writes.intersects(&other.writes) || other.writes.intersects(&reads);
+        }
+    };
+
+
     class System {
 
     public:
+        virtual ~System() = default;
+
         virtual void update(DELTA_TYPE delta) = 0;
 
+        inline const SystemAccess& getAccess() {
+            return access;
+        }
+
+        inline void declareRead(ComponentId componentId) {
+            access.declared = true;
+            access.reads.set(componentId);
+        }
+
+        inline void declareWrite(ComponentId componentId) {
+            access.declared = true;
+            access.writes.set(componentId);
+        }
+
+        // For systems changing the structure of entities or sharing state outside of components
+        inline void declareExclusive() {
+            access.declared = true;
+            access.exclusive = true;
+        }
+
+    protected:
+        SystemAccess access;
+
     };
 
 
@@ -48,12 +90,14 @@ namespace sEcs {
 
     private:
         using sEcs::Core::registerComponent;
+        using sEcs::Core::registerArchetypeComponent;
+        using sEcs::Core::registerTagComponent;
         using sEcs::Core::generateEvent;
 
     public:
         EcsManager(const EcsManager&) = delete;
 
-        EcsManager();
+        explicit EcsManager(uint32 maxEntityAmount = MAX_ENTITY_AMOUNT);
 
 
         template<ConceptType::Type C_T>
@@ -76,7 +120,14 @@ namespace sEcs {
         EventId generateEvent(const std::string& eventName);
 
 
-        ComponentId registerComponent(const std::string& componentName, ComponentHandle* ch);
+        ComponentId registerComponent(const std::string& componentName, ComponentHandle* ch,
+                ComponentTraits traits = ComponentTraits());
+
+        ComponentId registerArchetypeComponent(const std::string& componentName, size_t typeSize, size_t alignment,
+                void(* destroyFunc)(void*), void(* moveFunc)(void* destination, void* source),
+                ComponentTraits traits = ComponentTraits());
+
+        ComponentId registerTagComponent(const std::string& componentName);
 
 
         SystemId addSystem(const std::string& systemName, const std::shared_ptr<System>& system);
@@ -100,8 +151,31 @@ namespace sEcs {
         }
 
 
+        // Delivers the observations, updates the systems in the order they were added and dispatches the queued
+        // events. Removals of tracked components older than the previous update get pruned.
         void update(DELTA_TYPE delta);
 
+        // Lets update() run systems concurrently as jobs, if their declared access doesn't conflict. Conflicting
+        // systems keep the order they were added in. Concurrent systems must not change the structure of entities.
+        // A threadAmount other than 0 recreates the job system with this amount of workers.
+        void setParallelUpdate(bool parallel, uint32 threadAmount = 0);
+
+        // Workers for parallel updates, parallel passes and jobs of the systems. Created on first use with one
+        // worker per hardware thread and shut down with the manager.
+        JobSystem& getJobSystem();
+
+        // The event producer of the current worker (by its thread index), nullptr for the thread owning the manager
+        // (which constructed it), whose events go to the queues directly. Other threads have no producer and can't
+        // enqueue events.
+        inline Events::EventProducer* getThreadProducer() {
+            uint32 index = jobSystem == nullptr ? 0 : jobSystem->getThreadIndex();
+            if (index != 0)
+                return &getProducer(index);
+            if (std::this_thread::get_id() != ownerThread)
+                throw std::logic_error("Only the thread owning the manager and its workers can enqueue events");
+            return nullptr;
+        }
+
 
     private:
         std::vector<std::shared_ptr<System>> systems;
@@ -109,6 +183,14 @@ namespace sEcs {
         std::vector<void*> pointers;
         sEcs::Register conceptRegisters[static_cast<int>(ConceptType::SIZE_T)];
 
+        std::unique_ptr<JobSystem> jobSystem;
+        bool parallelUpdate = false;
+        std::thread::id ownerThread = std::this_thread::get_id();
+
+        uint32 previousUpdateTick = 0;
+
+        void updateParallel(DELTA_TYPE delta);
+
     };
 
 
@@ -12,15 +12,131 @@
 #ifndef SIMPLE_EVENT_HANDLER_H
 #define SIMPLE_EVENT_HANDLER_H
 
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include "Typedef.h"
 
+#ifndef PRODUCER_BLOCK_SIZE     // bytes per block of the event queues of producer threads
+#define PRODUCER_BLOCK_SIZE 16384
+#endif
+
 namespace sEcs {
     namespace Events {
 
         class Listener {
         public:
             virtual void receive(EventId, const void* event) = 0;
+
+            // Queued events of one id at once, each event takes size bytes
+            virtual void receiveAll(EventId eventId, const void* events, uint32 amount, size_t size) {
+                for (uint32 i = 0; i < amount; i++)
+                    receive(eventId, static_cast<const char*>(events) + i * size);
+            }
+        };
+
+        // A listener without inheritance: function(context, event)
+        struct Delegate {
+            void (* function)(void* context, const void* event);
+            void* context;
+        };
+
+        // Handle to unsubscribe a delegate
+        struct Subscription {
+            EventId eventId = 0;
+            uint32 key = 0;     // 0 for delegates of all events
+            uint32 handle = 0;
+            uint32 generation = 0;
+        };
+
+        // The delegates of one id in a flat array. Handles find their delegate in O(1), unsubscribed delegates
+        // get swapped with the last one. While the id is emitted, the array doesn't move: unsubscribed delegates
+        // only get cleared and new ones are added afterwards.
+        struct DelegateList {
+            std::vector<Delegate> delegates;
+            std::vector<uint32> handles;        // of the delegates
+            std::vector<uint32> positions;      // of the handles in delegates, then in added
+            std::vector<uint32> generations;    // of the handles, increased by unsubscribing
+            std::vector<uint32> freeHandles;
+            std::vector<Delegate> added;        // subscribed while emitting
+            std::vector<uint32> addedHandles;
+            uint32 emitting = 0;
+            bool cleared = false;   // delegates, which got cleared while emitting
+        };
+
+        // Contiguous events of one id, keeps its memory when it gets cleared
+        struct EventBuffer {
+            std::unique_ptr<char[]> data;
+            uint32 amount = 0;
+            uint32 capacity = 0;
+        };
+
+        struct EventQueue {
+            bool queued = false;    // typed emitEvent enqueues the events
+            size_t size = 0;
+            void (* moveFunc)(void* destination, void* source) = nullptr;
+            void (* destroyFunc)(void*) = nullptr;
+            EventBuffer pending;
+            EventBuffer dispatching;
+        };
+
+        // Events of one producer thread, appended without locks. A single consumer (EventHandler) moves them
+        // into the queues of their ids, also while the producer keeps appending. The events are stored in a
+        // list of blocks, the producer only links new blocks and the consumer deletes the blocks it has read.
+        class EventProducer {
+
+        public:
+            EventProducer();
+
+            EventProducer(const EventProducer&) = delete;
+
+            ~EventProducer();
+
+            // Only for the producer thread. Returns memory for the event, see EventHandler::enqueueEvent.
+            // The event gets visible to the consumer with publish.
+            void* enqueueEvent(EventId eventId, size_t size, size_t alignment,
+                               void(* moveFunc)(void* destination, void* source), void(* destroyFunc)(void*));
+
+            // Only for the producer thread. Publishes the event of the last enqueueEvent.
+            inline void publish() {
+                tail->published.store(used, std::memory_order_release);
+            }
+
+        private:
+            friend class EventHandler;
+
+            struct Block {
+                explicit Block(size_t size) : data(new char[size]), size(size) {}
+
+                std::atomic<size_t> published{0};   // bytes of complete events
+                std::atomic<Block*> next{nullptr};
+                std::unique_ptr<char[]> data;
+                size_t size;
+            };
+
+            // in front of each event
+            struct Header {
+                EventId eventId;
+                uint32 event;   // offset within the block
+                uint32 size;
+                void (* moveFunc)(void*, void*);
+                void (* destroyFunc)(void*);
+            };
+
+            Block* tail;    // the producer appends here
+            size_t used = 0;
+
+            Block* head;    // the consumer reads here
+            size_t read = 0;
+
+            std::atomic<Block*> spare{nullptr};    // a read block for the producer to reuse
+
+            // Consumer only. Calls func(header, event) for the published events and deletes read blocks.
+            template<typename Func>
+            void consume(Func func);
+
         };
 
         class EventHandler {
@@ -28,16 +144,147 @@ namespace sEcs {
         public:
             EventHandler();
 
+            ~EventHandler();
+
             EventId generateEvent();
 
             void subscribeEvent(uint32_t eventId, Listener* listener);
 
             void unsubscribeEvent(uint32_t eventId, Listener* toRemove);
 
-            void emitEvent(uint32_t eventId, const void* event);
+            // The delegate may subscribe and unsubscribe delegates, while the event gets emitted. Delegates, which
+            // got subscribed meanwhile, receive the next events. The order of the delegates isn't kept.
+            Subscription subscribeEvent(uint32_t eventId, Delegate delegate);
+
+            // Only receives the events emitted with the key (e.g. an EntityIndex), key 0 is the same as no key.
+            // Emitting an event only looks up the delegates of its own key.
+            Subscription subscribeEvent(uint32_t eventId, uint32 key, Delegate delegate);
+
+            // Ignores subscriptions, which were unsubscribed already
+            void unsubscribeEvent(Subscription subscription);
+
+            // Unsubscribes the delegates of the key for all events
+            void unsubscribeKey(uint32 key);
+
+            inline bool hasKeySubscriptions(uint32 key) const {
+                return key < keySubscribers.size() && keySubscribers[key] != 0;
+            }
+
+            // Calls the listeners and then the delegates. Events with delegates only are a plain loop over them.
+            inline void emitEvent(uint32_t eventId, const void* event) {
+                if (!listeners[eventId].empty())
+                    emitToListeners(eventId, event);
+                DelegateList& list = delegates[eventId];
+                if (!list.delegates.empty())
+                    emitToDelegates(list, event);
+            }
+
+            // Calls the delegates of the key after the ones of emitEvent
+            void emitEvent(uint32_t eventId, uint32 key, const void* event);
+
+            // Listeners and delegates (also the ones of keys), so emitters can skip constructing events
+            inline bool hasListeners(uint32_t eventId) const {
+                return subscribers[eventId] != 0;
+            }
+
+            // Returns memory for the event, which gets dispatched by dispatchQueued. All events of one id need the
+            // same size and functions. Without moveFunc the events get moved by memcpy, without destroyFunc
+            // nothing is destroyed.
+            void* enqueueEvent(uint32_t eventId, size_t size, size_t alignment,
+                               void(* moveFunc)(void* destination, void* source), void(* destroyFunc)(void*));
+
+            // Collects the events of the producers and hands the queued events of each id to each listener at once
+            // (receiveAll), in the order the ids got their first event. Events enqueued by the listeners get
+            // dispatched next time.
+            void dispatchQueued();
+
+            // Only the queued events of one id
+            void dispatchQueued(uint32_t eventId);
+
+            // Only a hint for typed emitters, emitEvent itself always dispatches immediately
+            inline void setQueued(uint32_t eventId, bool queued) {
+                queues[eventId].queued = queued;
+            }
+
+            inline bool isQueued(uint32_t eventId) const {
+                return queues[eventId].queued;
+            }
+
+            // Creates the producers 0 to amount - 1, while no producer is in use
+            void reserveProducers(uint32 amount);
+
+            inline EventProducer& getProducer(uint32 producer) {
+                return *producers[producer];
+            }
+
+            inline uint32 getProducerAmount() const {
+                return producers.size();
+            }
+
+            // Moves the published events of all producers into the queues of dispatchQueued, ordered by producer
+            // and then in the order they were published. Only for one thread at once, the producers may keep
+            // publishing meanwhile.
+            void collectProduced();
 
         private:
             std::vector<std::vector<Listener*>> listeners;
+            std::deque<DelegateList> delegates;     // by EventId, keeps their place when events get generated
+            std::vector<uint32> subscribers;        // listeners and delegates by EventId
+
+            // by keyOf(eventId, key), the lists keep their place and aren't removed, so handles stay unique
+            std::unordered_map<uint64, DelegateList> keyedDelegates;
+            std::vector<uint32> keySubscribers;     // delegates by key
+            std::vector<EventId> keyedEventIds;     // ids with delegates of keys
+
+            std::vector<EventQueue> queues;     // by EventId
+            std::vector<EventId> pendingIds;    // ids with pending events, by their first event
+
+            std::vector<std::unique_ptr<EventProducer>> producers;
+
+            void dispatch(EventId eventId);
+
+            static inline uint64 keyOf(EventId eventId, uint32 key) {
+                return (uint64(eventId) << 32u) | key;
+            }
+
+            Subscription add(DelegateList& list, EventId eventId, uint32 key, Delegate delegate);
+
+            void remove(DelegateList& list, EventId eventId, uint32 key, uint32 handle);
+
+            void emitToListeners(EventId eventId, const void* event);
+
+            // Marks the list as emitting, also if a delegate throws
+            struct Emitting {
+                EventHandler* handler;
+                DelegateList& list;
+
+                Emitting(EventHandler* handler, DelegateList& list) : handler(handler), list(list) {
+                    list.emitting++;
+                }
+
+                ~Emitting() {
+                    if (--list.emitting == 0 && (list.cleared || !list.added.empty()))
+                        handler->compact(list);
+                }
+            };
+
+            // The array doesn't move meanwhile, cleared delegates get skipped
+            inline void emitToDelegates(DelegateList& list, const void* event) {
+                Emitting emitting(this, list);
+                const Delegate* end = list.delegates.data() + list.delegates.size();
+                for (const Delegate* delegate = list.delegates.data(); delegate != end; ++delegate) {
+                    auto function = delegate->function;
+                    if (function != nullptr)
+                        function(delegate->context, event);
+                }
+            }
+
+            void emitToDelegates(DelegateList& list, const void* events, uint32 amount, size_t size);
+
+            // Removes the cleared delegates and adds the ones subscribed while emitting
+            void compact(DelegateList& list);
+
+            void clear(EventQueue& queue, EventBuffer& buffer);
 
         };
 
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2019 Nico Kluge <klugenico@mailbox.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file LICENSE, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Nico Kluge <klugenico@mailbox.org>
+ */
+
+
+#ifndef SIMPLEECS_JOBSYSTEM_H
+#define SIMPLEECS_JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Typedef.h"
+
+namespace sEcs {
+
+    // Counts the unfinished jobs submitted with it. Jobs may submit further jobs with the same counter.
+    class JobCounter {
+
+    public:
+        JobCounter() : pending(0) {}
+
+        JobCounter(const JobCounter&) = delete;
+
+        inline bool isDone() const {
+            return pending.load(std::memory_order_acquire) == 0;
+        }
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<uint32> pending;
+        std::mutex mutex;
+        std::exception_ptr exception;   // the first one thrown by a job
+
+    };
+
+
+    // Worker threads with one deque of jobs each. Workers take their own jobs newest first and steal the oldest
+    // jobs of other workers, if they run out of jobs. Threads waiting for a counter execute jobs meanwhile.
+    class JobSystem {
+
+    public:
+        // 0 uses one thread per hardware thread
+        explicit JobSystem(uint32 threadAmount = 0);
+
+        JobSystem(const JobSystem&) = delete;
+
+        // Executes the queued jobs and joins the workers
+        ~JobSystem();
+
+        // Workers push to their own deque, other threads distribute the jobs over the workers
+        void submit(std::function<void()> job, JobCounter& counter);
+
+        // Executes jobs until all jobs of the counter are done. Rethrows the first exception of these jobs.
+        void wait(JobCounter& counter);
+
+        // Calls func(begin, end) for chunks of up to chunkSize positions in [0, amount). The chunks are claimed by
+        // the workers and the calling thread, which returns after the last chunk is done. Rethrows the first exception.
+        void parallelFor(uint32 amount, uint32 chunkSize, const std::function<void(uint32 begin, uint32 end)>& func);
+
+        inline uint32 getThreadAmount() {
+            return workers.size();
+        }
+
+        // 1 to getThreadAmount() for the workers, 0 for other threads
+        uint32 getThreadIndex();
+
+    private:
+        struct Job {
+            std::function<void()> func;
+            JobCounter* counter;
+        };
+
+        struct Worker {
+            std::thread thread;
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<uint32> queuedJobs;
+        std::atomic<uint32> nextWorker;
+
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+        std::atomic<uint32> sleeping;
+        bool stopping = false;
+
+        void work(uint32 index);
+
+        // Takes a job of the own deque or steals one, returns false if there is none
+        bool runJob(uint32 index);
+
+        void run(Job& job);
+
+    };
+
+}
+
+#endif //SIMPLEECS_JOBSYSTEM_H
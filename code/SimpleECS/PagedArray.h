@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2019 Nico Kluge <klugenico@mailbox.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file LICENSE, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Nico Kluge <klugenico@mailbox.org>
+ */
+
+
+#ifndef SIMPLEECS_PAGEDARRAY_H
+#define SIMPLEECS_PAGEDARRAY_H
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "Typedef.h"
+
+namespace sEcs {
+
+    namespace Core_Intern {     // private
+
+        // Array indexed by EntityIndex, which grows on demand in pages of ENTITY_PAGE_SIZE elements.
+        // Elements never move, so their addresses stay valid while the array grows.
+        template<typename T>
+        class PagedArray {
+
+        public:
+            PagedArray() = default;
+
+            PagedArray(const PagedArray&) = delete;
+
+            ~PagedArray() {
+                if (!std::is_trivially_destructible<T>::value)
+                    for (Page& page : pages)
+                        for (uint32 i = 0; i < ENTITY_PAGE_SIZE; i++)
+                            page.elements[i].~T();
+            }
+
+            inline T& operator[](uint32 index) {
+                return pages[index / ENTITY_PAGE_SIZE].elements[index % ENTITY_PAGE_SIZE];
+            }
+
+            // Makes the index accessible. New elements are value initialized.
+            inline void ensure(uint32 index) {
+                while (pages.size() <= index / ENTITY_PAGE_SIZE)
+                    addPage();
+            }
+
+            inline uint32 capacity() const {
+                return pages.size() * ENTITY_PAGE_SIZE;
+            }
+
+        private:
+            struct Page {
+                std::unique_ptr<char[]> memory;
+                T* elements;
+            };
+
+            std::vector<Page> pages;
+
+            // new[] only aligns to max_align_t before C++17, so the elements get aligned within the memory
+            void addPage() {
+                Page page;
+                page.memory.reset(new char[ENTITY_PAGE_SIZE * sizeof(T) + alignof(T) - 1]);
+                auto address = reinterpret_cast<std::uintptr_t>(page.memory.get());
+                page.elements = reinterpret_cast<T*>((address + alignof(T) - 1) / alignof(T) * alignof(T));
+                for (uint32 i = 0; i < ENTITY_PAGE_SIZE; i++)
+                    new(&page.elements[i]) T();
+                pages.push_back(std::move(page));
+            }
+
+        };
+
+    }      // end private
+
+}
+
+#endif //SIMPLEECS_PAGEDARRAY_H
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2019 Nico Kluge <klugenico@mailbox.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file LICENSE, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Nico Kluge <klugenico@mailbox.org>
+ */
+
+
+#ifndef SIMPLEECS_SLABALLOCATOR_H
+#define SIMPLEECS_SLABALLOCATOR_H
+
+#include <cstddef>
+#include <vector>
+#include "Typedef.h"
+
+namespace sEcs {
+
+    struct SlabStats {
+        uint32 slabs = 0;
+        uint32 usedBlocks = 0;
+        uint32 capacity = 0;    // blocks of all slabs
+    };
+
+
+    // Allocates blocks of one size from slabs of SLAB_SIZE bytes. Freed blocks are reused via free lists,
+    // empty slabs get released, except the last one with free blocks. Not thread safe.
+    class SlabAllocator {
+
+    public:
+        SlabAllocator(size_t typeSize, size_t alignment);
+
+        SlabAllocator(const SlabAllocator&) = delete;
+
+        ~SlabAllocator();
+
+        void* allocate();
+
+        void deallocate(void* block);
+
+        SlabStats getStats() const;
+
+    private:
+        struct Slab {
+            char* memory = nullptr;     // as allocated, data is aligned within it
+            char* data = nullptr;
+            void* freeList = nullptr;
+            uint32 used = 0;
+            uint32 untouched = 0;   // blocks from here on were never allocated
+            bool available = true;
+        };
+
+        size_t blockSize;
+        size_t alignment;
+        uint32 blocksPerSlab;
+        uint32 usedBlocks = 0;
+
+        std::vector<Slab*> slabs;        // sorted by address
+        std::vector<Slab*> available;    // slabs with free blocks
+
+        Slab* findSlab(void* block);
+
+        void release(Slab* slab);
+
+    };
+
+}
+
+#endif //SIMPLEECS_SLABALLOCATOR_H
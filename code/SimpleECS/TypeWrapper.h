@@ -12,11 +12,16 @@
 #ifndef SIMPLE_ECS_TYPE_WRAPPER_H
 #define SIMPLE_ECS_TYPE_WRAPPER_H
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <type_traits>
 #include <memory>
+#include <tuple>
 #include <sstream>
 
 #include "Core.h"
+#include "CommandBuffer.h"
 #include "EventHandler.h"
 #include "ComponentHandler.h"
 #include "Register.h"
@@ -28,16 +33,22 @@ namespace sEcs {
 
     using sEcs::INVALID;
     using sEcs::NOT_AVAILABLE;
+    using sEcs::Events::Subscription;
 
 #if USE_ECS_EVENTS==1
     using sEcs::Events::EntityCreatedEvent;
     using sEcs::Events::EntityErasedEvent;
+    using sEcs::Events::EntitiesCreatedEvent;
+    using sEcs::Events::EntitiesErasedEvent;
 #endif
 
     namespace Storing {
         enum Type {
             POINTER,
-            VALUE
+            VALUE,
+            ARCHETYPE,  // pointers to components are only valid until the entity's components change
+            SPARSE,     // for rare components, pointers are only valid until components of this type change
+            TAG         // for empty components, only stored as bit. Empty trivially destructible types are always tags.
         };
     }
 
@@ -56,23 +67,25 @@ namespace sEcs {
 
         template<ConceptType::Type ID_T, typename T>
         sEcs::Id getSetId(sEcs::Id id = 0) {
-            static sEcs::Id _id = id;
+            static std::atomic<sEcs::Id> _id(id);     // looked up by systems running concurrently
 
             if (id != 0)
                 _id = id;
 
-            if (_id == 0) {
+            sEcs::Id known = _id;
+            if (known == 0) {
                 Key key = className<T>();
-                _id = manager()->getIdByName<ID_T>(key);
+                known = manager()->getIdByName<ID_T>(key);
 
-                if (_id == 0) {
+                if (known == 0) {
                     std::ostringstream oss;
                     oss << "Tried to access unregistered Type: " << key;
                     throw std::invalid_argument(oss.str());
                 }
+                _id = known;
             }
 
-            return _id;
+            return known;
         }
 
 
@@ -89,8 +102,56 @@ namespace sEcs {
         }
 
 
+        // The handle of the current manager, if it stores the components in a TypedComponentHandle, otherwise
+        // nullptr. It's looked up per manager, because it's destroyed with the manager.
+        template<typename T>
+        inline TypedComponentHandle<T>* typedHandle(sEcs::ComponentId componentId) {
+            ComponentHandle* handle = ECS_MANAGER_INSTANCE->getComponentHandle(componentId);
+            return handle->isTyped() ? static_cast<TypedComponentHandle<T>*>(handle) : nullptr;
+        }
+
+        // All tags of a type share one address.
+        template<typename T>
+        inline T* tagAddress() {
+            static typename std::aligned_storage<sizeof(T), alignof(T)>::type tag;
+            return reinterpret_cast<T*>(&tag);
+        }
+
+        // Move constructs the component at destination and destroys the source.
+        template<typename T>
+        void relocate(void* destination, void* source) {
+            new(destination) T(std::move(*reinterpret_cast<T *>(source)));
+            reinterpret_cast<T *>(source)->~T();
+        }
+
+        template<typename T>
+        void destroy(void* component) {
+            reinterpret_cast<T *>(component)->~T();
+        }
+
+        // nullptr lets the storages skip destruction
+        template<typename T>
+        inline void (* destroyFunc())(void*) {
+            return std::is_trivially_destructible<T>::value ? nullptr : &destroy<T>;
+        }
+
+        // nullptr lets the storages move by memcpy
+        template<typename T>
+        inline void (* moveFunc())(void*, void*) {
+            return std::is_trivially_copyable<T>::value ? nullptr : &relocate<T>;
+        }
+
+        template<typename T>
+        inline ComponentTraits componentTraits() {
+            ComponentTraits traits;
+            traits.triviallyDestructible = std::is_trivially_destructible<T>::value;
+            traits.triviallyCopyable = std::is_trivially_copyable<T>::value;
+            return traits;
+        }
+
+
         template<typename V>
-        inline void recursiveCollectComponentIds(sEcs::ComponentId* list, uint32_t pos) {}
+        inline void recursiveCollectComponentIds(sEcs::ComponentId*, uint32_t) {}
 
         template<typename V, typename T, typename... Ts>
         inline void recursiveCollectComponentIds(sEcs::ComponentId* list, uint32_t pos) {
@@ -103,6 +164,49 @@ namespace sEcs {
             return recursiveCollectComponentIds<void, Ts...>(list, 0);
         }
 
+
+        // Copy constructs the component for all entities in one loop
+        template<typename T>
+        void placeCopies(const sEcs::EntityId* entityIds, uint32 amount, const T& component) {
+            sEcs::ComponentId componentId = getSetId<ConceptType::COMPONENT, T>();
+            if (manager()->isTag(componentId))
+                return;
+
+            TypedComponentHandle<T>* handle = typedHandle<T>(componentId);
+            if (handle != nullptr) {
+                for (uint32 i = 0; i < amount; i++)
+                    new(handle->get(entityIds[i].index)) T(component);
+                return;
+            }
+
+            ComponentHandle* ch = manager()->getComponentHandle(componentId);
+            for (uint32 i = 0; i < amount; i++)
+                new(ch->getComponent(entityIds[i].index)) T(component);
+        }
+
+        inline void recursivePlaceCopies(const sEcs::EntityId*, uint32) {}
+
+        template<typename T, typename... Ts>
+        inline void recursivePlaceCopies(const sEcs::EntityId* entityIds, uint32 amount,
+                                         const T& component, const Ts&... components) {
+            placeCopies(entityIds, amount, component);
+            recursivePlaceCopies(entityIds, amount, components...);
+        }
+
+        template<typename T, typename... Ts>
+        struct ContainsType : std::false_type {};
+
+        template<typename T, typename U, typename... Ts>
+        struct ContainsType<T, U, Ts...> : std::integral_constant<bool,
+                std::is_same<T, U>::value || ContainsType<T, Ts...>::value> {};
+
+        template<typename... Ts>
+        struct DistinctTypes : std::true_type {};
+
+        template<typename T, typename... Ts>
+        struct DistinctTypes<T, Ts...> : std::integral_constant<bool,
+                !ContainsType<T, Ts...>::value && DistinctTypes<Ts...>::value> {};
+
     }
 
 
@@ -120,6 +224,31 @@ namespace sEcs {
 
         EntityId entityId;
     };
+
+    // Only emitted after setReplaceEvents<T>(true), otherwise a replaced component emits deleted and added
+    template<typename T>
+    struct ComponentReplacedEvent {
+        explicit ComponentReplacedEvent(const EntityId& entityId) : entityId(entityId) {}
+
+        EntityId entityId;
+    };
+
+    namespace TypeWrapper_Intern {
+
+        // The events, which query subscriptions can filter by the entity
+        template<typename T>
+        struct IsEntityEvent : std::is_same<T, EntityErasedEvent> {};
+
+        template<typename T>
+        struct IsEntityEvent<ComponentAddedEvent<T>> : std::true_type {};
+
+        template<typename T>
+        struct IsEntityEvent<ComponentDeletedEvent<T>> : std::true_type {};
+
+        template<typename T>
+        struct IsEntityEvent<ComponentReplacedEvent<T>> : std::true_type {};
+
+    }
 #endif
 
 
@@ -164,10 +293,25 @@ namespace sEcs {
             return ECS_MANAGER_INSTANCE->deleteComponent(entityId, TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, T>());
         }
 
+        // Marks the component as changed, if its changes are tracked
         template<typename T>
         inline T* getComponent() {
-            return reinterpret_cast<T *>(
-                    ECS_MANAGER_INSTANCE->getComponent(entityId, TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, T>()));
+            return fetchComponent<T, true>();
+        }
+
+        // Like getComponent, but without marking the component as changed
+        template<typename T>
+        inline T* readComponent() {
+            return fetchComponent<T, false>();
+        }
+
+        // For changes without getComponent, e.g. through a stored pointer
+        template<typename T>
+        inline void markChanged() {
+            sEcs::ComponentId componentId = TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, T>();
+            sEcs::EntityIndex index = ECS_MANAGER_INSTANCE->getIndex(entityId);
+            if (index != INVALID && ECS_MANAGER_INSTANCE->hasComponent(index, componentId))
+                ECS_MANAGER_INSTANCE->markChanged(index, componentId);
         }
 
         inline sEcs::EntityId id() {
@@ -177,6 +321,27 @@ namespace sEcs {
     private:
         sEcs::EntityId entityId;
 
+        template<typename T, bool MARK>
+        inline T* fetchComponent() {
+            sEcs::ComponentId componentId = TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, T>();
+            TypedComponentHandle<T>* handle = TypeWrapper_Intern::typedHandle<T>(componentId);
+
+            // Typed fast path without virtual calls
+            if (handle != nullptr || (std::is_empty<T>::value && ECS_MANAGER_INSTANCE->isTag(componentId))) {
+                sEcs::EntityIndex index = ECS_MANAGER_INSTANCE->getIndex(entityId);
+                if (index == INVALID || !ECS_MANAGER_INSTANCE->hasComponent(index, componentId))
+                    return nullptr;
+                if (MARK)
+                    ECS_MANAGER_INSTANCE->markChanged(index, componentId);
+                return handle != nullptr ? handle->get(index) : TypeWrapper_Intern::tagAddress<T>();
+            }
+
+            auto* component = reinterpret_cast<T *>(ECS_MANAGER_INSTANCE->getComponent(entityId, componentId));
+            if (MARK && component != nullptr)
+                ECS_MANAGER_INSTANCE->markChanged(entityId.index, componentId);
+            return component;
+        }
+
         template<typename... Ts>
         void placeComponents(Ts&&... components) {
             return recursivePlaceComponents(std::forward<Ts>(components)...);
@@ -205,6 +370,10 @@ namespace sEcs {
                 manager()->entityCreatedEventId(), TypeWrapper_Intern::className<EntityCreatedEvent>());
         manager()->name<ConceptType::EVENT>(
                 manager()->entityErasedEventId(), TypeWrapper_Intern::className<EntityErasedEvent>());
+        manager()->name<ConceptType::EVENT>(
+                manager()->entitiesCreatedEventId(), TypeWrapper_Intern::className<EntitiesCreatedEvent>());
+        manager()->name<ConceptType::EVENT>(
+                manager()->entitiesErasedEventId(), TypeWrapper_Intern::className<EntitiesErasedEvent>());
 #endif
     }
 
@@ -225,10 +394,76 @@ namespace sEcs {
         return { Entity(manager()->createEntity() ) };
     }
 
+    // Creates the entities at once, each with a copy of the components. Returns less entities, if the maximum
+    // amount of entities is reached.
+    template<typename... Ts>
+    std::vector<Entity> createEntities(sEcs::uint32 amount, const Ts&... components) {
+        static_assert(TypeWrapper_Intern::DistinctTypes<Ts...>::value, "Each component can be passed only once");
+        sEcs::ComponentId ids[sizeof...(Ts) + 1];
+        TypeWrapper_Intern::collectComponentIds<Ts...>(ids);
+
+        std::vector<sEcs::EntityId> entityIds(amount);
+        amount = manager()->createEntities(amount, entityIds.data(), ids, sizeof...(Ts));
+        TypeWrapper_Intern::recursivePlaceCopies(entityIds.data(), amount, components...);
+
+        std::vector<Entity> entities;
+        entities.reserve(amount);
+        for (sEcs::uint32 i = 0; i < amount; i++)
+            entities.emplace_back(entityIds[i]);
+        return entities;
+    }
+
     inline void eraseEntity(sEcs::Entity entity) {
         manager()->eraseEntity(entity.id());
     }
 
+    // Erases the entities at once, see Core::eraseEntities
+    inline sEcs::uint32 eraseEntities(const std::vector<Entity>& entities) {
+        static_assert(sizeof(Entity) == sizeof(sEcs::EntityId), "Entities are passed as their ids");
+        return entities.empty() ? 0 : manager()->eraseEntities(
+                reinterpret_cast<const sEcs::EntityId*>(&entities.front()), entities.size());
+    }
+
+
+    // Records structural changes to apply them later in one pass with playback(), e.g. while iterating or from
+    // other threads (one buffer per thread). Entities created by the buffer are only valid within the same buffer
+    // until the playback.
+    class CommandBuffer : public Commands::CommandBuffer {
+
+    public:
+        inline Entity createEntity() {
+            return Entity(Commands::CommandBuffer::createEntity());
+        }
+
+        template<typename T>
+        void addComponent(Entity entity, T&& component) {
+            typedef typename std::decay<T>::type Component;
+            sEcs::ComponentId componentId = TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, Component>();
+            // only tags store no value, other empty components still get constructed
+            bool tag = std::is_empty<Component>::value && manager()->isTag(componentId);
+            void* value = Commands::CommandBuffer::addComponent(entity.id(), componentId,
+                    tag ? 0 : sizeof(Component), alignof(Component),
+                    TypeWrapper_Intern::moveFunc<Component>(), TypeWrapper_Intern::destroyFunc<Component>());
+            if (value != nullptr)
+                new(value) Component(std::forward<T>(component));
+        }
+
+        template<typename T>
+        void deleteComponent(Entity entity) {
+            Commands::CommandBuffer::deleteComponent(entity.id(),
+                    TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, T>());
+        }
+
+        inline void eraseEntity(Entity entity) {
+            Commands::CommandBuffer::eraseEntity(entity.id());
+        }
+
+        inline void playback() {
+            Commands::CommandBuffer::playback(*manager());
+        }
+
+    };
+
 
     // This method generates a new list with related entities, if not already existing.
     template<typename ... Ts>
@@ -290,14 +525,31 @@ namespace sEcs {
     void registerComponent(Storing::Type storing = Storing::VALUE) {
         Key key = TypeWrapper_Intern::className<T>();
         sEcs::ComponentId compId = 0;
+        ComponentTraits traits = TypeWrapper_Intern::componentTraits<T>();
+
+        if (std::is_empty<T>::value && std::is_trivially_destructible<T>::value)
+            storing = Storing::TAG;
+
         switch (storing) {
             case Storing::POINTER:
-                compId = manager()->registerComponent(key,
-                        new PointingComponentHandle(sizeof(T), [](void *p) { delete reinterpret_cast<T *>(p); }));
+                compId = manager()->registerComponent(key, new PointingComponentHandle(
+                        sizeof(T), TypeWrapper_Intern::destroyFunc<T>(), alignof(T)), traits);
                 break;
             case Storing::VALUE:
-                compId = manager()->registerComponent(key,
-                        new ValuedComponentHandle(sizeof(T), [](void *p) { reinterpret_cast<T *>(p)->~T(); }));
+                compId = manager()->registerComponent(key, new TypedComponentHandle<T>(), traits);
+                break;
+            case Storing::ARCHETYPE:
+                compId = manager()->registerArchetypeComponent(key, sizeof(T), alignof(T),
+                        TypeWrapper_Intern::destroyFunc<T>(), TypeWrapper_Intern::moveFunc<T>(), traits);
+                break;
+            case Storing::SPARSE:
+                compId = manager()->registerComponent(key, new SparseSetComponentHandle(sizeof(T),
+                        TypeWrapper_Intern::destroyFunc<T>(), TypeWrapper_Intern::moveFunc<T>()), traits);
+                break;
+            case Storing::TAG:
+                if (!std::is_empty<T>::value)
+                    throw std::invalid_argument("Only empty components can be tags: " + key);
+                compId = manager()->registerTagComponent(key);
                 break;
         }
         TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, T>(compId);
@@ -307,16 +559,697 @@ namespace sEcs {
                 manager()->componentAddedEventId(compId), TypeWrapper_Intern::className<ComponentAddedEvent<T>>());
         manager()->name<ConceptType::EVENT>(
                 manager()->componentDeletedEventId(compId), TypeWrapper_Intern::className<ComponentDeletedEvent<T>>());
+        manager()->name<ConceptType::EVENT>(
+                manager()->componentReplacedEventId(compId), TypeWrapper_Intern::className<ComponentReplacedEvent<T>>());
 #endif
 
     }
 
+#if USE_ECS_EVENTS==1
+    // Overwriting a trivially copyable component emits one ComponentReplacedEvent<T> instead of deleted and added
+    template<typename T>
+    void setReplaceEvents(bool replaceEvents) {
+        manager()->setReplaceEvents(TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, T>(), replaceEvents);
+    }
+
+    // Switches ComponentAddedEvent<T>, ComponentDeletedEvent<T> and ComponentReplacedEvent<T> on or off
+    template<typename T>
+    void setComponentEvents(bool enabled) {
+        manager()->setComponentEvents(TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, T>(), enabled);
+    }
+#endif
+
+
+    // Queries with Added<T>, Changed<T> or Removed<T> track the changes of T automatically
+    template<typename T>
+    void trackChanges() {
+        manager()->trackChanges(TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, T>());
+    }
+
+    // The callbacks get the entities, which got or lost T, at once per update (or deliverObservations)
+    template<typename T>
+    ObserverId observe(std::function<void(const EntityId* entityIds, uint32 amount)> onAdded,
+                       std::function<void(const EntityId* entityIds, uint32 amount)> onRemoved = nullptr) {
+        return manager()->observe(TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, T>(),
+                                  std::move(onAdded), std::move(onRemoved));
+    }
+
+    inline void unobserve(ObserverId observerId) {
+        manager()->unobserve(observerId);
+    }
+
+    inline void deliverObservations() {
+        manager()->deliverObservations();
+    }
+
+
+    // Query parameter: only entities without the component T
+    template<typename T>
+    struct Without {};
+
+    // Query parameter: the component T doesn't restrict the entities, views pass it as pointer or nullptr
+    template<typename T>
+    struct Optional {};
+
+    // Query parameter: only entities, which got the component T since the previous pass of the query
+    template<typename T>
+    struct Added {};
+
+    // Query parameter: only entities, whose component T was added or changed since the previous pass of the query.
+    // Components count as changed, when they are fetched mutable (views with non-const T, getComponent) or marked.
+    template<typename T>
+    struct Changed {};
+
+    // Query parameter: views pass the entities, which lost the component T since their previous pass, once per
+    // removal. Erased entities are left out.
+    template<typename T>
+    struct Removed {};
+
+    // Query parameters without a view, e.g. for subscribeEvent
+    template<typename... Ts>
+    struct Query {};
+
+
+    namespace TypeWrapper_Intern {
+
+        namespace ChangeKind {
+            enum Type {
+                NONE,
+                ADDED,
+                CHANGED,
+                REMOVED
+            };
+        }
+
+        // const components are only read by systems
+        template<typename T>
+        struct QueryPart {
+            typedef typename std::remove_const<T>::type Component;
+            static const bool REQUIRED = true;
+            static const bool ACCESSED = true;
+            static const bool WRITTEN = !std::is_const<T>::value;
+            static const ChangeKind::Type CHANGE = ChangeKind::NONE;
+        };
+
+        template<typename T>
+        struct QueryPart<Without<T>> {
+            typedef typename std::remove_const<T>::type Component;
+            static const bool REQUIRED = false;
+            static const bool ACCESSED = false;
+            static const bool WRITTEN = false;
+            static const ChangeKind::Type CHANGE = ChangeKind::NONE;
+        };
+
+        template<typename T>
+        struct QueryPart<Optional<T>> {
+            typedef typename std::remove_const<T>::type Component;
+            static const bool REQUIRED = false;
+            static const bool ACCESSED = true;
+            static const bool WRITTEN = !std::is_const<T>::value;
+            static const ChangeKind::Type CHANGE = ChangeKind::NONE;
+        };
+
+        // Change filters read the ticks of the component
+        template<typename T>
+        struct QueryPart<Added<T>> {
+            typedef typename std::remove_const<T>::type Component;
+            static const bool REQUIRED = true;
+            static const bool ACCESSED = true;
+            static const bool WRITTEN = false;
+            static const ChangeKind::Type CHANGE = ChangeKind::ADDED;
+        };
+
+        template<typename T>
+        struct QueryPart<Changed<T>> {
+            typedef typename std::remove_const<T>::type Component;
+            static const bool REQUIRED = true;
+            static const bool ACCESSED = true;
+            static const bool WRITTEN = false;
+            static const ChangeKind::Type CHANGE = ChangeKind::CHANGED;
+        };
+
+        template<typename T>
+        struct QueryPart<Removed<T>> {
+            typedef typename std::remove_const<T>::type Component;
+            static const bool REQUIRED = false;
+            static const bool ACCESSED = true;
+            static const bool WRITTEN = false;
+            static const ChangeKind::Type CHANGE = ChangeKind::REMOVED;
+        };
+
+        template<typename V>
+        inline void recursiveCollectQuery(std::vector<sEcs::ComponentId>&,
+                                          std::vector<sEcs::ComponentId>&) {}
+
+        template<typename V, typename T, typename... Ts>
+        inline void recursiveCollectQuery(std::vector<sEcs::ComponentId>& componentIds,
+                                          std::vector<sEcs::ComponentId>& excludedIds) {
+            sEcs::ComponentId componentId = getSetId<ConceptType::COMPONENT, typename QueryPart<T>::Component>();
+            if (QueryPart<T>::REQUIRED)
+                componentIds.push_back(componentId);
+            else if (!QueryPart<T>::ACCESSED)
+                excludedIds.push_back(componentId);
+            recursiveCollectQuery<void, Ts...>(componentIds, excludedIds);
+        }
+
+        template<typename V>
+        inline void recursiveDeclareAccess(System*) {}
+
+        template<typename V, typename T, typename... Ts>
+        inline void recursiveDeclareAccess(System* system) {
+            sEcs::ComponentId componentId = getSetId<ConceptType::COMPONENT, typename QueryPart<T>::Component>();
+            if (QueryPart<T>::WRITTEN)
+                system->declareWrite(componentId);
+            else if (QueryPart<T>::ACCESSED)
+                system->declareRead(componentId);
+            recursiveDeclareAccess<void, Ts...>(system);
+        }
+
+        // Components are declared as written, const components as read
+        template<typename... Ts>
+        void declareQueryAccess(System* system) {
+            recursiveDeclareAccess<void, Ts...>(system);
+        }
+
+        // Splits components, Without<T> and Optional<T> into required and excluded components
+        template<typename... Ts>
+        void collectQuery(std::vector<sEcs::ComponentId>& componentIds, std::vector<sEcs::ComponentId>& excludedIds) {
+            recursiveCollectQuery<void, Ts...>(componentIds, excludedIds);
+        }
+
+
+        template<ChangeKind::Type KIND, typename... Ts>
+        struct CountChanges : std::integral_constant<sEcs::uint32, 0> {};
+
+        template<ChangeKind::Type KIND, typename T, typename... Ts>
+        struct CountChanges<KIND, T, Ts...> : std::integral_constant<sEcs::uint32,
+                (QueryPart<T>::CHANGE == KIND ? 1 : 0) + CountChanges<KIND, Ts...>::value> {};
+
+        // Passes only entities, whose components of Added<T> and Changed<T> got their ticks after the previous
+        // pass ended. Queries with Removed<T> visit the removals since the previous pass began instead.
+        template<typename... Ts>
+        class ChangeFilter {
+
+        public:
+            static const sEcs::uint32 FILTERED = CountChanges<ChangeKind::ADDED, Ts...>::value
+                                                 + CountChanges<ChangeKind::CHANGED, Ts...>::value;
+            static const sEcs::uint32 REMOVED = CountChanges<ChangeKind::REMOVED, Ts...>::value;
+            static const bool ACTIVE = FILTERED + REMOVED > 0;
+
+            ChangeFilter() {
+                collect<void, Ts...>();
+            }
+
+            // Starts a pass, which passes the changes since the previous one
+            inline void begin() {
+                removedSince = began;
+                began = manager()->advanceChangeTick();
+            }
+
+            // Ends the pass. Its own changes got the ticks up to now, so the next pass only takes the ticks after
+            // them and a query doesn't pass again what it changed itself.
+            inline void end() {
+                since = manager()->advanceChangeTick();
+            }
+
+            inline bool passes(sEcs::EntityIndex entityIndex) const {
+                for (const Condition& condition : conditions) {
+                    const Core_Intern::ComponentTicks& ticks = condition.tracking->get(entityIndex);
+                    if ((condition.added ? ticks.added : ticks.changed) < since)
+                        return false;
+                }
+                return true;
+            }
+
+            inline sEcs::uint32 getRemovedSince() const {
+                return removedSince;
+            }
+
+            inline Core_Intern::ChangeTracking* getRemovals() const {
+                return removals;
+            }
+
+        private:
+            struct Condition {
+                Core_Intern::ChangeTracking* tracking;
+                bool added;
+            };
+
+            std::vector<Condition> conditions;
+            Core_Intern::ChangeTracking* removals = nullptr;
+            sEcs::uint32 since = 0;         // the first tick after the previous pass
+            sEcs::uint32 began = 0;
+            sEcs::uint32 removedSince = 0;
+
+            template<typename V>
+            inline void collect() {}
+
+            template<typename V, typename T, typename... Rs>
+            inline void collect() {
+                if (QueryPart<T>::CHANGE != ChangeKind::NONE) {
+                    sEcs::ComponentId componentId = getSetId<ConceptType::COMPONENT, typename QueryPart<T>::Component>();
+                    manager()->trackChanges(componentId);
+                    Core_Intern::ChangeTracking* tracking = manager()->getChangeTracking(componentId);
+                    if (QueryPart<T>::CHANGE == ChangeKind::REMOVED)
+                        removals = tracking;
+                    else
+                        conditions.push_back({tracking, QueryPart<T>::CHANGE == ChangeKind::ADDED});
+                }
+                collect<void, Rs...>();
+            }
+
+        };
+
+    }
+
 
     template<typename ... Ts>
     SetIteratorId createSetIterator() {
-        std::vector<ComponentId> componentIds = std::vector<sEcs::ComponentId>(sizeof...(Ts));
-        TypeWrapper_Intern::collectComponentIds<Ts...>(&componentIds[0]);
-        return manager()->createSetIterator(componentIds);
+        std::vector<ComponentId> componentIds;
+        std::vector<ComponentId> excludedIds;
+        TypeWrapper_Intern::collectQuery<Ts...>(componentIds, excludedIds);
+        return manager()->createSetIterator(componentIds, excludedIds);
+    }
+
+    // Erases all entities of the query at once, e.g. Without<T> excludes entities with T
+    template<typename ... Ts>
+    sEcs::uint32 eraseAll() {
+        std::vector<ComponentId> componentIds;
+        std::vector<ComponentId> excludedIds;
+        TypeWrapper_Intern::collectQuery<Ts...>(componentIds, excludedIds);
+        return manager()->clearQuery(*manager()->makeSetIterator(componentIds, excludedIds));
+    }
+
+
+    namespace TypeWrapper_Intern {
+
+        // Fetches components by entity index without validating the entity or its components
+        template<typename T>
+        class ComponentAccess {
+
+        public:
+            ComponentAccess() :
+                    componentId(getSetId<ConceptType::COMPONENT, T>()),
+                    typed(typedHandle<T>(componentId)),
+                    handle(manager()->getComponentHandle(componentId)),
+                    tag(manager()->isTag(componentId)) {}
+
+            inline T* get(sEcs::EntityIndex entityIndex) {
+                if (typed != nullptr)
+                    return typed->get(entityIndex);
+                if (tag)
+                    return tagAddress<T>();
+                return reinterpret_cast<T *>(handle->getComponent(entityIndex));
+            }
+
+            sEcs::ComponentId componentId;
+
+        private:
+            TypedComponentHandle<T>* typed;
+            ComponentHandle* handle;
+            bool tag;
+
+        };
+
+        // Marks mutable fetched components as changed, if their changes are tracked
+        template<typename T>
+        class ChangeMarker {
+
+        public:
+            // Tracking may start after the view got created
+            inline void begin(sEcs::ComponentId componentId) {
+                tracking = std::is_const<T>::value ? nullptr : manager()->getChangeTracking(componentId);
+            }
+
+            inline void mark(sEcs::EntityIndex entityIndex) {
+                if (tracking != nullptr)
+                    tracking->change(entityIndex, manager()->getChangeTick());
+            }
+
+            inline void markChunk(Core_Intern::Archetype* archetype, sEcs::uint32 row, sEcs::uint32 amount) {
+                if (tracking != nullptr)
+                    for (sEcs::uint32 i = 0; i < amount; i++)
+                        mark(archetype->getEntity(row + i));
+            }
+
+        private:
+            Core_Intern::ChangeTracking* tracking = nullptr;
+
+        };
+
+        // What a view passes for a query parameter: T&, T* for Optional<T> and nothing for Without<T> and the
+        // change filters. matches() checks entities, which are not taken from the set of the query.
+        template<typename T>
+        struct ViewAccess : public ComponentAccess<typename std::remove_const<T>::type> {
+            typedef std::tuple<T&> Passed;
+
+            inline void begin() {
+                marker.begin(this->componentId);
+            }
+
+            inline bool matches(sEcs::EntityIndex entityIndex) {
+                return manager()->hasComponent(entityIndex, this->componentId);
+            }
+
+            // the set iterator only walks archetypes, if all required components are stored in them
+            inline bool chunked() {
+                return true;
+            }
+
+            inline T& fetch(sEcs::EntityIndex entityIndex) {
+                marker.mark(entityIndex);
+                return *this->get(entityIndex);
+            }
+
+            inline T* fetchChunk(Core_Intern::Archetype* archetype, sEcs::uint32 row, sEcs::uint32 amount) {
+                marker.markChunk(archetype, row, amount);
+                return reinterpret_cast<T *>(archetype->get(row, this->componentId));
+            }
+
+        private:
+            ChangeMarker<T> marker;
+        };
+
+        template<typename T>
+        struct ViewAccess<Optional<T>> : public ComponentAccess<typename std::remove_const<T>::type> {
+            typedef std::tuple<T*> Passed;
+
+            inline void begin() {
+                marker.begin(this->componentId);
+            }
+
+            inline bool matches(sEcs::EntityIndex) {
+                return true;
+            }
+
+            // components stored elsewhere are missing in every archetype, they have to be fetched per entity
+            inline bool chunked() {
+                return manager()->isArchetypeStored(this->componentId);
+            }
+
+            inline T* fetch(sEcs::EntityIndex entityIndex) {
+                if (!manager()->hasComponent(entityIndex, this->componentId))
+                    return nullptr;
+                marker.mark(entityIndex);
+                return this->get(entityIndex);
+            }
+
+            inline T* fetchChunk(Core_Intern::Archetype* archetype, sEcs::uint32 row, sEcs::uint32 amount) {
+                if (!archetype->contains(this->componentId))
+                    return nullptr;
+                marker.markChunk(archetype, row, amount);
+                return reinterpret_cast<T *>(archetype->get(row, this->componentId));
+            }
+
+        private:
+            ChangeMarker<T> marker;
+        };
+
+        // Query parameters, which only restrict the entities
+        template<typename T, bool PRESENT>
+        struct FilterAccess {
+            typedef std::tuple<> Passed;
+
+            FilterAccess() : componentId(getSetId<ConceptType::COMPONENT, typename std::remove_const<T>::type>()) {}
+
+            inline void begin() {}
+
+            inline bool matches(sEcs::EntityIndex entityIndex) {
+                return manager()->hasComponent(entityIndex, componentId) == PRESENT;
+            }
+
+            inline bool chunked() {
+                return true;
+            }
+
+            sEcs::ComponentId componentId;
+        };
+
+        template<typename T>
+        struct ViewAccess<Without<T>> : public FilterAccess<T, false> {};
+
+        // the ticks are checked by the ChangeFilter
+        template<typename T>
+        struct ViewAccess<Added<T>> : public FilterAccess<T, true> {};
+
+        template<typename T>
+        struct ViewAccess<Changed<T>> : public FilterAccess<T, true> {};
+
+        template<typename T>
+        struct ViewAccess<Removed<T>> {
+            typedef std::tuple<> Passed;
+
+            inline void begin() {}
+
+            inline bool matches(sEcs::EntityIndex) {
+                return true;
+            }
+
+            inline bool chunked() {
+                return true;
+            }
+        };
+
+        template<typename Func, typename Passed>
+        struct AcceptsEntityId;
+
+        template<typename Func, typename... Args>
+        struct AcceptsEntityId<Func, std::tuple<Args...>> {
+            template<typename F>
+            static auto test(int) -> decltype(std::declval<F&>()(EntityId(), std::declval<Args>()...), std::true_type());
+
+            template<typename F>
+            static std::false_type test(long);
+
+            static const bool value = decltype(test<Func>(0))::value;
+        };
+
+    }
+
+
+    // Iterates over all entities of a query and hands their components to a callback. The components are fetched
+    // once per entity and not validated again, because the set guarantees them.
+    // Query parameters are components, Without<T>, Optional<T> and the change filters Added<T>, Changed<T> and
+    // Removed<T>, which refer to the previous pass of the view.
+    // Create views once (e.g. as member of a system), they must not outlive the manager.
+    template<typename ... Ts>
+    class View {
+
+        static_assert(sizeof...(Ts) > 0, "A view needs at least one component");
+
+        typedef decltype(std::tuple_cat(std::declval<typename TypeWrapper_Intern::ViewAccess<Ts>::Passed>()...)) Passed;
+        typedef TypeWrapper_Intern::ChangeFilter<Ts...> Filter;
+
+        static_assert(Filter::REMOVED <= 1, "A view can pass the removals of one component only");
+
+    public:
+        View() {
+            if (Filter::REMOVED > 0)    // the removals are visited instead of a set
+                return;
+            std::vector<sEcs::ComponentId> componentIds;
+            std::vector<sEcs::ComponentId> excludedIds;
+            TypeWrapper_Intern::collectQuery<Ts...>(componentIds, excludedIds);
+            iterator = manager()->makeSetIterator(componentIds, excludedIds);
+        }
+
+        // Calls func(Ts&...) or func(EntityId, Ts&...) for every entity, Optional<T> is passed as T*, Without<T>
+        // and the change filters are left out
+        template<typename Func>
+        void each(Func func) {
+            std::integral_constant<bool, TypeWrapper_Intern::AcceptsEntityId<Func, Passed>::value> withEntityId;
+            begin();
+            if (Filter::REMOVED > 0)
+                eachRemoval(func, withEntityId);
+            else
+                eachEntity(func, withEntityId);
+            end();
+        }
+
+        // Calls func(uint32 amount, Ts*...) with arrays of amount components each. If all components, including the
+        // optional ones, are archetype stored, the arrays span whole chunks, otherwise they contain a single entity. Optional components are
+        // nullptr for the whole array, if missing. The components of the entities must not change meanwhile.
+        template<typename Func>
+        void eachChunk(Func func) {
+            static_assert(!Filter::ACTIVE, "eachChunk can't filter changes");
+            begin();
+            auto* archetypeIterator = dynamic_cast<Core_Intern::ArchetypeSetIterator *>(iterator.get());
+            if (archetypeIterator == nullptr || !chunked<0>()) {
+                Core_Intern::IterationGuard guard(iterator.get());
+                for (sEcs::EntityIndex index = iterator->next(); index != INVALID; index = iterator->next()) {
+                    auto fetch = [this, index](auto& access) { return pointer(access.fetch(index)); };
+                    pass<0>(fetch, func, sEcs::uint32(1));
+                }
+                return;
+            }
+
+            for (ArchetypeId archetypeId : archetypeIterator->getMatching()) {
+                Core_Intern::Archetype* archetype = archetypeIterator->getStorage()->getArchetype(archetypeId);
+                sEcs::uint32 capacity = archetype->getChunkCapacity();
+                for (sEcs::uint32 row = 0; row < archetype->getAmount(); row += capacity) {
+                    sEcs::uint32 amount = std::min(capacity, archetype->getAmount() - row);
+                    auto fetch = [archetype, row, amount](auto& access) {
+                        return access.fetchChunk(archetype, row, amount);
+                    };
+                    pass<0>(fetch, func, amount);
+                }
+            }
+        }
+
+        // Like each, but calls func concurrently on the job system of the manager. func must not add or remove
+        // entities or components, but can record them in a CommandBuffer per thread.
+        template<typename Func>
+        void eachParallel(Func func, sEcs::uint32 chunkSize = PARALLEL_CHUNK_SIZE) {
+            static_assert(Filter::REMOVED == 0, "eachParallel can't pass removals");
+            std::integral_constant<bool, TypeWrapper_Intern::AcceptsEntityId<Func, Passed>::value> withEntityId;
+            begin();
+            {
+                Core_Intern::PassGuard pass(iterator.get());
+                manager()->getJobSystem().parallelFor(pass.getEnd(), chunkSize,
+                                                      [&](sEcs::uint32 begin, sEcs::uint32 end) {
+                    for (sEcs::uint32 position = begin; position < end; position++) {
+                        sEcs::EntityIndex index = iterator->at(position);
+                        if (index != INVALID && (Filter::FILTERED == 0 || filter.passes(index)))
+                            passEntity(func, index, withEntityId);
+                    }
+                });
+            }
+            end();
+        }
+
+        // All entities of the query, regardless of the change filters
+        inline sEcs::uint32 count() {
+            static_assert(Filter::REMOVED == 0, "Views of removals can't count them");
+            return iterator->getAmount();
+        }
+
+    private:
+        typedef std::tuple<TypeWrapper_Intern::ViewAccess<Ts>...> Access;
+
+        std::unique_ptr<Core_Intern::SetIterator> iterator;
+        Access access;
+        Filter filter;
+
+        inline void begin() {
+            if (Filter::ACTIVE)
+                filter.begin();
+            beginAccess<0>();
+        }
+
+        inline void end() {
+            if (Filter::ACTIVE)
+                filter.end();
+        }
+
+        template<size_t I>
+        inline typename std::enable_if<I == sizeof...(Ts)>::type beginAccess() {}
+
+        template<size_t I>
+        inline typename std::enable_if<(I < sizeof...(Ts))>::type beginAccess() {
+            std::get<I>(access).begin();
+            beginAccess<I + 1>();
+        }
+
+        template<size_t I>
+        inline typename std::enable_if<I == sizeof...(Ts), bool>::type chunked() {
+            return true;
+        }
+
+        template<size_t I>
+        inline typename std::enable_if<(I < sizeof...(Ts)), bool>::type chunked() {
+            return std::get<I>(access).chunked() && chunked<I + 1>();
+        }
+
+        template<size_t I>
+        inline typename std::enable_if<I == sizeof...(Ts), bool>::type matches(sEcs::EntityIndex) {
+            return true;
+        }
+
+        template<size_t I>
+        inline typename std::enable_if<(I < sizeof...(Ts)), bool>::type matches(sEcs::EntityIndex index) {
+            return std::get<I>(access).matches(index) && matches<I + 1>(index);
+        }
+
+        template<size_t I, typename = void>
+        struct PassesParameter : std::false_type {};
+
+        template<size_t I>
+        struct PassesParameter<I, typename std::enable_if<(I < sizeof...(Ts))>::type> : std::integral_constant<bool,
+                (std::tuple_size<typename std::tuple_element<I, Access>::type::Passed>::value > 0)> {};
+
+        template<typename Func, typename WithEntityId>
+        inline void eachEntity(Func& func, WithEntityId withEntityId) {
+            Core_Intern::IterationGuard guard(iterator.get());
+            for (sEcs::EntityIndex index = iterator->next(); index != INVALID; index = iterator->next())
+                if (Filter::FILTERED == 0 || filter.passes(index))
+                    passEntity(func, index, withEntityId);
+        }
+
+        // Removals during the pass are passed by the next one
+        template<typename Func, typename WithEntityId>
+        inline void eachRemoval(Func& func, WithEntityId withEntityId) {
+            const std::vector<Core_Intern::ComponentRemoval>& removals = filter.getRemovals()->getRemovals();
+            size_t end = removals.size();
+            for (size_t i = 0; i < end; i++) {
+                if (removals[i].tick < filter.getRemovedSince())
+                    continue;
+                sEcs::EntityIndex index = manager()->getIndex(removals[i].entityId);
+                if (index != INVALID && matches<0>(index) && filter.passes(index))
+                    passEntity(func, index, withEntityId);
+            }
+        }
+
+        template<typename Func>
+        inline void passEntity(Func& func, sEcs::EntityIndex index, std::true_type) {
+            auto fetch = [index](auto& access) -> decltype(auto) { return access.fetch(index); };
+            pass<0>(fetch, func, manager()->getIdFromIndex(index));
+        }
+
+        template<typename Func>
+        inline void passEntity(Func& func, sEcs::EntityIndex index, std::false_type) {
+            auto fetch = [index](auto& access) -> decltype(auto) { return access.fetch(index); };
+            pass<0>(fetch, func);
+        }
+
+        template<typename T>
+        static inline T* pointer(T& component) {
+            return &component;
+        }
+
+        template<typename T>
+        static inline T* pointer(T* component) {
+            return component;
+        }
+
+        // Appends the fetched component of query parameter I to the arguments and calls func after the last one
+        template<size_t I, typename Fetch, typename Func, typename... Args>
+        inline typename std::enable_if<I == sizeof...(Ts)>::type
+        pass(Fetch&, Func& func, Args&&... args) {
+            func(std::forward<Args>(args)...);
+        }
+
+        template<size_t I, typename Fetch, typename Func, typename... Args>
+        inline typename std::enable_if<PassesParameter<I>::value>::type
+        pass(Fetch& fetch, Func& func, Args&&... args) {
+            pass<I + 1>(fetch, func, std::forward<Args>(args)..., fetch(std::get<I>(access)));
+        }
+
+        template<size_t I, typename Fetch, typename Func, typename... Args>
+        inline typename std::enable_if<(I < sizeof...(Ts)) && !PassesParameter<I>::value>::type
+        pass(Fetch& fetch, Func& func, Args&&... args) {
+            pass<I + 1>(fetch, func, std::forward<Args>(args)...);
+        }
+
+    };
+
+    template<typename ... Ts>
+    View<Ts...> view() {
+        return View<Ts...>();
+    }
+
+    // Single pass over a temporary view, prefer a stored view for frequent passes
+    template<typename ... Ts, typename Func>
+    void each(Func func) {
+        View<Ts...>().each(func);
     }
 
 
@@ -325,14 +1258,66 @@ namespace sEcs {
     public:
         virtual void receive(const T& event) = 0;
 
-        void receive(EventId eventId, const void* event) override {
+        // Queued events at once, override it to handle them as a batch
+        virtual void receiveAll(const T* events, uint32 amount) {
+            for (uint32 i = 0; i < amount; i++)
+                receive(events[i]);
+        }
+
+        void receive(EventId, const void* event) override {
             receive(*(reinterpret_cast <const T *>(event)));
         }
+
+        void receiveAll(EventId, const void* events, uint32 amount, size_t) override {
+            receiveAll(reinterpret_cast<const T *>(events), amount);
+        }
     };
 
+    // Appends the event to the queue of T, dispatchQueued hands all of them to the listeners at once.
+    // Events without listeners get dropped. Workers of the job system append to their own producer without
+    // locks, dispatchQueued collects their events ordered by the thread index. Other threads than the workers and
+    // the one owning the manager get a std::logic_error. The listeners of T are looked up without locks, so they
+    // must not change and T must have its id (e.g. by subscribing) while workers enqueue events.
+    template<typename T>
+    void enqueueEvent(const T& event) {
+        Events::EventProducer* producer = manager()->getThreadProducer();
+        EventId eventId = TypeWrapper_Intern::getGenerateEventId<T>();
+        if (!manager()->hasListeners(eventId))
+            return;
+        if (producer == nullptr) {
+            new (manager()->enqueueEvent(eventId, sizeof(T), alignof(T), TypeWrapper_Intern::moveFunc<T>(),
+                                         TypeWrapper_Intern::destroyFunc<T>())) T(event);
+            return;
+        }
+        new (producer->enqueueEvent(eventId, sizeof(T), alignof(T), TypeWrapper_Intern::moveFunc<T>(),
+                                    TypeWrapper_Intern::destroyFunc<T>())) T(event);
+        producer->publish();
+    }
+
+    // Lets emitEvent enqueue the events of T instead of dispatching them immediately
+    template<typename T>
+    void setQueuedEvents(bool queued) {
+        manager()->setQueued(TypeWrapper_Intern::getGenerateEventId<T>(), queued);
+    }
+
     template<typename T>
     void emitEvent(const T& event) {
-        manager()->emitEvent(TypeWrapper_Intern::getGenerateEventId<T>(), &event);
+        EventId eventId = TypeWrapper_Intern::getGenerateEventId<T>();
+        sEcs::EcsManager* ecs = manager();
+        if (ecs->isQueued(eventId))
+            enqueueEvent(event);
+        else
+            ecs->emitEvent(eventId, &event);
+    }
+
+    // Dispatches the queued events of all types, EcsManager::update does it at the end
+    inline void dispatchQueued() {
+        manager()->dispatchQueued();
+    }
+
+    template<typename T>
+    void dispatchQueued() {
+        manager()->dispatchQueued(TypeWrapper_Intern::getGenerateEventId<T>());
     }
 
     template<typename T>
@@ -345,15 +1330,85 @@ namespace sEcs {
         manager()->unsubscribeEvent(TypeWrapper_Intern::getGenerateEventId<T>(), listener);
     }
 
+    namespace TypeWrapper_Intern {
+
+        template<typename T, void (* Func)(const T&)>
+        void callFunction(void*, const void* event) {
+            Func(*static_cast<const T*>(event));
+        }
+
+        template<typename T, typename C, void (C::* Method)(const T&)>
+        void callMethod(void* context, const void* event) {
+            (static_cast<C*>(context)->*Method)(*static_cast<const T*>(event));
+        }
+
+    }
+
+    // Subscribes a free function without a Listener, e.g. subscribeEvent<Collision, &onCollision>()
+    template<typename T, void (* Func)(const T&)>
+    Subscription subscribeEvent() {
+        return manager()->subscribeEvent(TypeWrapper_Intern::getGenerateEventId<T>(),
+                                         Events::Delegate{&TypeWrapper_Intern::callFunction<T, Func>, nullptr});
+    }
+
+    // Subscribes a method of the object, e.g. subscribeEvent<Collision, Sound, &Sound::play>(&sound). The
+    // method gets called directly instead of through virtual receive calls.
+    template<typename T, typename C, void (C::* Method)(const T&)>
+    Subscription subscribeEvent(C* object) {
+        return manager()->subscribeEvent(TypeWrapper_Intern::getGenerateEventId<T>(),
+                                         Events::Delegate{&TypeWrapper_Intern::callMethod<T, C, Method>, object});
+    }
+
+    // Only the events of the entity (ComponentAddedEvent<T>, ComponentDeletedEvent<T>, ComponentReplacedEvent<T>
+    // and EntityErasedEvent), e.g. subscribeEvent<ComponentAddedEvent<Health>, Bar, &Bar::show>(&bar, player).
+    // The events of other entities don't touch the delegate. It gets unsubscribed when the entity is erased.
+    template<typename T, typename C, void (C::* Method)(const T&)>
+    Subscription subscribeEvent(C* object, Entity entity) {
+        return manager()->subscribeEntityEvent(TypeWrapper_Intern::getGenerateEventId<T>(), entity.id(),
+                                               Events::Delegate{&TypeWrapper_Intern::callMethod<T, C, Method>, object});
+    }
+
+    // One subscription per entity
+    template<typename T, typename C, void (C::* Method)(const T&)>
+    std::vector<Subscription> subscribeEvent(C* object, const std::vector<Entity>& entities) {
+        std::vector<Subscription> subscriptions;
+        subscriptions.reserve(entities.size());
+        for (Entity entity : entities)
+            subscriptions.push_back(subscribeEvent<T, C, Method>(object, entity));
+        return subscriptions;
+    }
+
+    // Only the events of entities, which match the query when the event is emitted, e.g.
+    // subscribeEvent<ComponentDeletedEvent<Health>, Stats, &Stats::count>(&stats, Query<Player, Without<Ghost>>())
+    template<typename T, typename C, void (C::* Method)(const T&), typename... Ts>
+    Subscription subscribeEvent(C* object, Query<Ts...>) {
+        static_assert(!TypeWrapper_Intern::ChangeFilter<Ts...>::ACTIVE, "Change filters aren't supported here");
+        static_assert(TypeWrapper_Intern::IsEntityEvent<T>::value,
+                      "Only component events and EntityErasedEvent can be filtered by a query");
+        std::vector<ComponentId> componentIds;
+        std::vector<ComponentId> excludedIds;
+        TypeWrapper_Intern::collectQuery<Ts...>(componentIds, excludedIds);
+        return manager()->subscribeEntityEvent(TypeWrapper_Intern::getGenerateEventId<T>(), componentIds, excludedIds,
+                                               Events::Delegate{&TypeWrapper_Intern::callMethod<T, C, Method>, object});
+    }
+
+    inline void unsubscribeEvent(Subscription subscription) {
+        manager()->unsubscribeEvent(subscription);
+    }
+
 
     template<typename ... Ts>
     class IteratingSystem : public Systems::IteratingSystem {
 
+        static_assert(!TypeWrapper_Intern::ChangeFilter<Ts...>::ACTIVE,
+                      "Change filters are supported by views, IterateAllSystem and ParallelIterateAllSystem");
+
     public:
         IteratingSystem() : Systems::IteratingSystem(manager()) {
-            componentIds = std::vector<sEcs::ComponentId>(sizeof...(Ts));
-            TypeWrapper_Intern::collectComponentIds<Ts...>(&componentIds[0]);
-            setIteratorId = _core->createSetIterator(componentIds);
+            std::vector<sEcs::ComponentId> excludedIds;
+            TypeWrapper_Intern::collectQuery<Ts...>(componentIds, excludedIds);
+            setIteratorId = _core->createSetIterator(componentIds, excludedIds);
+            TypeWrapper_Intern::declareQueryAccess<Ts...>(this);
         }
 
         virtual void update(Entity entity, DELTA_TYPE delta) = 0;
@@ -361,34 +1416,56 @@ namespace sEcs {
     };
 
 
+    // Added<T> and Changed<T> refer to the changes after the previous update of the system
     template<typename ... Ts>
     class IterateAllSystem : public Systems::IterateAllSystem {
 
+        typedef TypeWrapper_Intern::ChangeFilter<Ts...> Filter;
+
+        static_assert(Filter::REMOVED == 0, "Removals are only passed by views");
+
     public:
         IterateAllSystem() : Systems::IterateAllSystem(manager()) {
-            componentIds = std::vector<sEcs::ComponentId>(sizeof...(Ts));
-            TypeWrapper_Intern::collectComponentIds<Ts...>(&componentIds[0]);
-            setIteratorId = _core->createSetIterator(componentIds);
+            std::vector<sEcs::ComponentId> excludedIds;
+            TypeWrapper_Intern::collectQuery<Ts...>(componentIds, excludedIds);
+            setIteratorId = _core->createSetIterator(componentIds, excludedIds);
+            TypeWrapper_Intern::declareQueryAccess<Ts...>(this);
         }
 
         virtual void update(Entity entity, DELTA_TYPE delta) = 0;
 
         void update(EntityId entityId, DELTA_TYPE delta) override {
-            update(Entity(entityId), delta);
+            if (Filter::FILTERED == 0 || filter.passes(entityId.index))
+                update(Entity(entityId), delta);
         }
 
+        void update(DELTA_TYPE delta) override {
+            if (Filter::ACTIVE)
+                filter.begin();
+            Systems::IterateAllSystem::update(delta);
+            if (Filter::ACTIVE)
+                filter.end();
+        }
+
+    private:
+        Filter filter;
+
     };
 
 
     template<typename ... Ts>
     class IntervalSystem : public Systems::IntervalSystem {
 
+        static_assert(!TypeWrapper_Intern::ChangeFilter<Ts...>::ACTIVE,
+                      "Change filters are supported by views, IterateAllSystem and ParallelIterateAllSystem");
+
     public:
         explicit IntervalSystem(sEcs::uint32 intervals = 1)
                 : Systems::IntervalSystem(manager(), intervals) {
-            componentIds = std::vector<sEcs::ComponentId>(sizeof...(Ts));
-            TypeWrapper_Intern::collectComponentIds<Ts...>(&componentIds[0]);
-            setIteratorId = _core->createSetIterator(componentIds);
+            std::vector<sEcs::ComponentId> excludedIds;
+            TypeWrapper_Intern::collectQuery<Ts...>(componentIds, excludedIds);
+            setIteratorId = _core->createSetIterator(componentIds, excludedIds);
+            TypeWrapper_Intern::declareQueryAccess<Ts...>(this);
         }
 
         virtual void update(Entity entity, DELTA_TYPE delta) = 0;
@@ -399,6 +1476,79 @@ namespace sEcs {
 
     };
 
+
+    // Calls update(Entity, delta) concurrently on the job system of the manager, start and end run on the updating
+    // thread. Adding or removing entities and components within update(Entity, delta) has to be recorded in
+    // commands(), the buffers of all threads are played back on the updating thread before end. Since the playback
+    // changes the structure of entities, these systems are exclusive and run alone, if the manager updates systems
+    // in parallel.
+    template<typename ... Ts>
+    class ParallelIterateAllSystem : public System {
+
+        typedef TypeWrapper_Intern::ChangeFilter<Ts...> Filter;
+
+        static_assert(Filter::REMOVED == 0, "Removals are only passed by views");
+
+    public:
+        explicit ParallelIterateAllSystem(sEcs::uint32 chunkSize = PARALLEL_CHUNK_SIZE) : chunkSize(chunkSize) {
+            std::vector<sEcs::ComponentId> componentIds;
+            std::vector<sEcs::ComponentId> excludedIds;
+            TypeWrapper_Intern::collectQuery<Ts...>(componentIds, excludedIds);
+            iterator = manager()->makeSetIterator(componentIds, excludedIds);
+            TypeWrapper_Intern::declareQueryAccess<Ts...>(this);
+            declareExclusive();
+        }
+
+        virtual void start(DELTA_TYPE) {};
+        virtual void update(Entity entity, DELTA_TYPE delta) = 0;
+        virtual void end(DELTA_TYPE) {};
+
+        void update(DELTA_TYPE delta) override {
+            JobSystem& jobSystem = manager()->getJobSystem();
+            while (buffers.size() <= jobSystem.getThreadAmount())
+                buffers.emplace_back(new CommandBuffer());
+
+            start(delta);
+
+            if (Filter::ACTIVE)
+                filter.begin();
+            try {
+                Core_Intern::PassGuard pass(iterator.get());
+                jobSystem.parallelFor(pass.getEnd(), chunkSize, [this, delta](sEcs::uint32 begin, sEcs::uint32 end) {
+                    for (sEcs::uint32 position = begin; position < end; position++) {
+                        sEcs::EntityIndex index = iterator->at(position);
+                        if (index != INVALID && (Filter::FILTERED == 0 || filter.passes(index)))
+                            update(Entity(manager()->getIdFromIndex(index)), delta);
+                    }
+                });
+            } catch (...) {
+                for (auto& buffer : buffers)
+                    buffer->clear();
+                throw;
+            }
+
+            for (auto& buffer : buffers)
+                buffer->playback();
+
+            end(delta);
+            if (Filter::ACTIVE)
+                filter.end();
+        }
+
+    protected:
+        // The command buffer of the current thread
+        inline CommandBuffer& commands() {
+            return *buffers[manager()->getJobSystem().getThreadIndex()];
+        }
+
+    private:
+        sEcs::uint32 chunkSize;
+        std::unique_ptr<Core_Intern::SetIterator> iterator;
+        std::vector<std::unique_ptr<CommandBuffer>> buffers;
+        Filter filter;
+
+    };
+
 }
 
 
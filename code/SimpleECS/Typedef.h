@@ -14,21 +14,38 @@
 
 #define POW_2_32 4294967296
 
-#define BITSET_TYPE std::uint8_t
-#define BITSET_TYPE_SIZE 8u
+#define BITSET_TYPE std::uint64_t
+#define BITSET_TYPE_SIZE 64u
 
 #ifndef USE_ECS_EVENTS
 #define USE_ECS_EVENTS 1
 #endif
 
-#ifndef MAX_COMPONENT_AMOUNT
+#ifndef MAX_COMPONENT_AMOUNT  // up to 1024 and more, each entity stores MAX_COMPONENT_AMOUNT / 8 bytes of flags
 #define MAX_COMPONENT_AMOUNT 63
 #endif
 
-#ifndef MAX_ENTITY_AMOUNT
+#ifndef MAX_ENTITY_AMOUNT  // default of the runtime limit, memory is allocated on demand
 #define MAX_ENTITY_AMOUNT 100000
 #endif
 
+#ifndef ENTITY_PAGE_SIZE
+#define ENTITY_PAGE_SIZE 4096u
+#endif
+
+#ifndef SLAB_SIZE
+#define SLAB_SIZE 65536
+#endif
+
+#ifndef ARCHETYPE_CHUNK_SIZE
+#define ARCHETYPE_CHUNK_SIZE 16384
+#endif
+
+#ifndef PARALLEL_CHUNK_SIZE  // entities per chunk of parallel passes, each thread claims whole chunks
+#define PARALLEL_CHUNK_SIZE 256u
+#endif
+
+#include <cstdint>
 #include <string>
 
 namespace sEcs {
@@ -42,6 +59,8 @@ namespace sEcs {
     typedef Id SetIteratorId;
     typedef Id EventId;
     typedef uint32 InternIndex;
+    typedef Id ArchetypeId;
+    typedef Id ObserverId;
     typedef std::string Key;
 
     struct EntityId {
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2019 Nico Kluge <klugenico@mailbox.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file LICENSE, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Nico Kluge <klugenico@mailbox.org>
+ */
+
+
+#include <algorithm>
+#include <stdexcept>
+#include "../Core.h"
+
+namespace sEcs {
+
+    namespace Core_Intern {     // private
+
+        const size_t Archetype::NO_COLUMN;
+
+        Archetype::Archetype(std::vector<ComponentId> componentIds, const std::vector<ArchetypeColumn>* columns) :
+                componentIds(std::move(componentIds)), columns(columns),
+                offsets(std::vector<size_t>(columns->size(), NO_COLUMN)) {
+
+            size_t rowSize = sizeof(EntityIndex);
+            size_t padding = 0;
+            for (ComponentId componentId : this->componentIds) {
+                rowSize += (*columns)[componentId].typeSize;
+                padding += (*columns)[componentId].alignment - 1;
+            }
+
+            if (ARCHETYPE_CHUNK_SIZE < padding + rowSize)
+                throw std::length_error("Components to big for one archetype chunk! Define by ARCHETYPE_CHUNK_SIZE.");
+            chunkCapacity = (ARCHETYPE_CHUNK_SIZE - padding) / rowSize;
+
+            size_t offset = chunkCapacity * sizeof(EntityIndex);
+            for (ComponentId componentId : this->componentIds) {
+                const ArchetypeColumn& column = (*columns)[componentId];
+                offset = (offset + column.alignment - 1) / column.alignment * column.alignment;
+                offsets[componentId] = offset;
+                offset += chunkCapacity * column.typeSize;
+            }
+        }
+
+        Archetype::~Archetype() {
+            for (Chunk* chunk : chunks) delete chunk;
+        }
+
+        uint32 Archetype::add(EntityIndex entityIndex) {
+            if (amount == chunks.size() * chunkCapacity)
+                chunks.push_back(new Chunk);
+
+            uint32 row = amount++;
+            reinterpret_cast<EntityIndex*>(chunks[row / chunkCapacity]->data)[row % chunkCapacity] = entityIndex;
+            return row;
+        }
+
+        EntityIndex Archetype::remove(uint32 row) {
+            uint32 last = --amount;
+            EntityIndex moved = INVALID;
+
+            if (row != last) {
+                for (ComponentId componentId : componentIds)
+                    (*columns)[componentId].move(get(row, componentId), get(last, componentId));
+                moved = getEntity(last);
+                reinterpret_cast<EntityIndex*>(chunks[row / chunkCapacity]->data)[row % chunkCapacity] = moved;
+            }
+
+            if (amount == (chunks.size() - 1) * chunkCapacity) {
+                delete chunks.back();
+                chunks.pop_back();
+            }
+
+            return moved;
+        }
+
+
+        ArchetypeStorage::ArchetypeStorage() {
+            columns.emplace_back();
+            getOrCreate(std::vector<ComponentId>());    // the root archetype without any components
+        }
+
+        ArchetypeStorage::~ArchetypeStorage() {
+            for (Archetype* archetype : archetypes) {
+                for (uint32 row = 0; row < archetype->getAmount(); row++)
+                    for (ComponentId componentId : archetype->getComponentIds())
+                        if (columns[componentId].destroyFunc != nullptr)
+                            columns[componentId].destroyFunc(archetype->get(row, componentId));
+                delete archetype;
+            }
+        }
+
+        void ArchetypeStorage::registerComponent(ComponentId componentId, size_t typeSize, size_t alignment,
+                                                 void(* destroyFunc)(void*), void(* moveFunc)(void*, void*)) {
+            if (alignment > alignof(Chunk))     // the columns are aligned relative to the chunk
+                throw std::invalid_argument("Archetype stored components can't be over-aligned");
+            if (columns.size() <= componentId)
+                columns.resize(componentId + 1);
+
+            ArchetypeColumn& column = columns[componentId];
+            column.typeSize = typeSize;
+            column.alignment = alignment;
+            column.destroyFunc = destroyFunc;
+            column.moveFunc = moveFunc;
+        }
+
+        ArchetypeId ArchetypeStorage::withComponent(ArchetypeId archetypeId, ComponentId componentId) {
+            Archetype* archetype = archetypes[archetypeId];
+            if (archetype->contains(componentId))
+                return archetypeId;
+
+            if (archetype->addEdges.size() <= componentId)
+                archetype->addEdges.resize(componentId + 1, INVALID);
+
+            if (archetype->addEdges[componentId] == INVALID) {
+                std::vector<ComponentId> componentIds = archetype->getComponentIds();
+                componentIds.insert(std::upper_bound(componentIds.begin(), componentIds.end(), componentId), componentId);
+                ArchetypeId target = getOrCreate(componentIds);
+                archetypes[archetypeId]->addEdges[componentId] = target;
+            }
+
+            return archetypes[archetypeId]->addEdges[componentId];
+        }
+
+        ArchetypeId ArchetypeStorage::withoutComponent(ArchetypeId archetypeId, ComponentId componentId) {
+            Archetype* archetype = archetypes[archetypeId];
+            if (!archetype->contains(componentId))
+                return archetypeId;
+
+            if (archetype->removeEdges.size() <= componentId)
+                archetype->removeEdges.resize(componentId + 1, INVALID);
+
+            // The root archetype shares its id with INVALID, so edges to it are not cached.
+            if (archetype->removeEdges[componentId] == INVALID) {
+                std::vector<ComponentId> componentIds = archetype->getComponentIds();
+                componentIds.erase(std::find(componentIds.begin(), componentIds.end(), componentId));
+                if (componentIds.empty())
+                    return 0;
+                ArchetypeId target = getOrCreate(componentIds);
+                archetypes[archetypeId]->removeEdges[componentId] = target;
+            }
+
+            return archetypes[archetypeId]->removeEdges[componentId];
+        }
+
+        void ArchetypeStorage::migrate(EntityIndex entityIndex, ArchetypeId target) {
+            locations.ensure(entityIndex);
+
+            ArchetypeLocation source = locations[entityIndex];
+            if (source.archetypeId == target)
+                return;
+
+            notifyWalkers();
+
+            Archetype* from = archetypes[source.archetypeId];
+            Archetype* to = archetypes[target];
+
+            uint32 row = 0;
+            if (target != 0) {
+                row = to->add(entityIndex);
+                for (ComponentId componentId : from->getComponentIds())
+                    if (to->contains(componentId))
+                        columns[componentId].move(to->get(row, componentId), from->get(source.row, componentId));
+            }
+
+            if (source.archetypeId != 0) {
+                EntityIndex moved = from->remove(source.row);
+                if (moved != INVALID)
+                    locations[moved].row = source.row;
+            }
+
+            locations[entityIndex] = {target, row};
+        }
+
+        void ArchetypeStorage::migrate(const EntityId* entityIds, uint32 amount, ArchetypeId target) {
+            if (amount == 0 || target == 0)
+                return;
+            notifyWalkers();
+
+            EntityIndex maxIndex = 0;
+            for (uint32 i = 0; i < amount; i++)
+                maxIndex = std::max(maxIndex, entityIds[i].index);
+            locations.ensure(maxIndex);
+
+            Archetype* to = archetypes[target];
+            for (uint32 i = 0; i < amount; i++)
+                locations[entityIds[i].index] = {target, to->add(entityIds[i].index)};
+        }
+
+        void ArchetypeStorage::notifyWalkers() {
+            std::vector<RowWalker*> notified;
+            {
+                std::lock_guard<std::mutex> lock(walkersMutex);
+                notified.swap(walkers);
+            }
+            for (RowWalker* walker : notified)
+                walker->beforeMigration();
+        }
+
+        void ArchetypeStorage::unwatch(RowWalker* walker) {
+            std::lock_guard<std::mutex> lock(walkersMutex);
+            auto found = std::find(walkers.begin(), walkers.end(), walker);
+            if (found != walkers.end())
+                walkers.erase(found);
+        }
+
+        ArchetypeId ArchetypeStorage::getOrCreate(const std::vector<ComponentId>& componentIds) {
+            auto found = archetypeIds.find(componentIds);
+            if (found != archetypeIds.end())
+                return found->second;
+
+            archetypes.push_back(new Archetype(componentIds, &columns));
+            ArchetypeId archetypeId = archetypes.size() - 1;
+            archetypeIds[componentIds] = archetypeId;
+            return archetypeId;
+        }
+
+    }      // end private
+
+}
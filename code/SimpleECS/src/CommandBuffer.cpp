@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2019 Nico Kluge <klugenico@mailbox.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file LICENSE, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Nico Kluge <klugenico@mailbox.org>
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include "../CommandBuffer.h"
+
+namespace sEcs {
+
+    namespace Commands {
+
+        CommandBuffer::~CommandBuffer() {
+            clear();
+        }
+
+        EntityId CommandBuffer::createEntity() {
+            if (playing)
+                throw std::logic_error("Recording into a CommandBuffer while playing it back");
+            return {0, ++createdAmount};     // version 0 is never valid in the Core
+        }
+
+        void* CommandBuffer::addComponent(EntityId entityId, ComponentId componentId, size_t size, size_t alignment,
+                                          void(* moveFunc)(void*, void*), void(* destroyFunc)(void*)) {
+            record(Type::ADD, entityId, componentId);
+            Command& command = commands.back();
+            command.value = size == 0 ? nullptr : allocate(size, alignment);
+            command.size = size;
+            command.moveFunc = moveFunc;
+            command.destroyFunc = destroyFunc;
+            return command.value;
+        }
+
+        void CommandBuffer::deleteComponent(EntityId entityId, ComponentId componentId) {
+            record(Type::DELETE, entityId, componentId);
+        }
+
+        void CommandBuffer::eraseEntity(EntityId entityId) {
+            record(Type::ERASE, entityId, 0);
+        }
+
+        void CommandBuffer::playback(Core& core) {
+            if (playing)
+                throw std::logic_error("Recording into a CommandBuffer while playing it back");
+            playing = true;
+
+            try {
+                std::vector<EntityId> created(createdAmount + 1);
+                for (uint32 i = 1; i <= createdAmount; i++)
+                    created[i] = core.createEntity();
+                for (Command& command : commands)
+                    if (command.entityId.version == 0)
+                        command.entityId = command.entityId.index <= createdAmount ? created[command.entityId.index]
+                                                                                   : EntityId();
+
+                // Commands grouped by entity, in recorded order within each group
+                std::vector<uint32> order(commands.size());
+                std::iota(order.begin(), order.end(), 0);
+                std::stable_sort(order.begin(), order.end(), [this](uint32 left, uint32 right) {
+                    return uint64(commands[left].entityId) < uint64(commands[right].entityId);
+                });
+
+                std::vector<ComponentId> addedIds;
+                std::vector<ComponentId> deletedIds;
+                std::vector<Command*> added;
+                for (size_t begin = 0, end = 0; begin < order.size(); begin = end) {
+                    EntityId entityId = commands[order[begin]].entityId;
+                    bool erase = false;
+                    for (end = begin; end < order.size() && commands[order[end]].entityId == entityId; end++)
+                        erase |= commands[order[end]].type == Type::ERASE;
+
+                    if (erase) {
+                        core.eraseEntity(entityId);
+                        continue;
+                    }
+
+                    addedIds.clear();
+                    deletedIds.clear();
+                    added.clear();
+                    Core_Intern::ComponentBitset decided;
+                    for (size_t i = end; i-- > begin;) {
+                        Command& command = commands[order[i]];
+                        if (decided.isSet(command.componentId))
+                            continue;
+                        decided.set(command.componentId);
+                        if (command.type == Type::ADD) {
+                            addedIds.push_back(command.componentId);
+                            added.push_back(&command);
+                        } else {
+                            deletedIds.push_back(command.componentId);
+                        }
+                    }
+
+                    if (!core.changeComponents(entityId, addedIds.data(), addedIds.size(),
+                                               deletedIds.data(), deletedIds.size()))
+                        continue;
+
+                    for (size_t i = added.size(); i-- > 0;) {
+                        Command& command = *added[i];
+                        void* component = command.value == nullptr ? nullptr
+                                                                   : core.getComponent(entityId, command.componentId);
+                        if (component == nullptr)
+                            continue;
+                        if (command.moveFunc == nullptr)
+                            std::memcpy(component, command.value, command.size);
+                        else
+                            command.moveFunc(component, command.value);
+                        command.value = nullptr;
+                    }
+                }
+            } catch (...) {
+                playing = false;
+                clear();
+                throw;
+            }
+
+            playing = false;
+            clear();
+        }
+
+        void CommandBuffer::clear() {
+            for (Command& command : commands)
+                if (command.value != nullptr && command.destroyFunc != nullptr)
+                    command.destroyFunc(command.value);
+            commands.clear();
+            createdAmount = 0;
+            currentBlock = 0;
+            used = 0;
+        }
+
+        void* CommandBuffer::allocate(size_t size, size_t alignment) {
+            while (true) {
+                if (currentBlock == blocks.size()) {
+                    size_t blockSize = std::max<size_t>(COMMAND_ARENA_BLOCK_SIZE, size + alignment);
+                    blocks.push_back(Block{std::unique_ptr<char[]>(new char[blockSize]), blockSize});
+                    used = 0;
+                }
+
+                Block& block = blocks[currentBlock];
+                auto base = reinterpret_cast<std::uintptr_t>(block.data.get());
+                size_t offset = ((base + used + alignment - 1) & ~(std::uintptr_t(alignment) - 1)) - base;
+                if (offset + size <= block.size) {
+                    used = offset + size;
+                    return block.data.get() + offset;
+                }
+
+                currentBlock++;
+                used = 0;
+            }
+        }
+
+        void CommandBuffer::record(Type type, EntityId entityId, ComponentId componentId) {
+            if (playing)
+                throw std::logic_error("Recording into a CommandBuffer while playing it back");
+            commands.push_back(Command{type, entityId, componentId, nullptr, 0, nullptr, nullptr});
+        }
+
+    }
+
+}
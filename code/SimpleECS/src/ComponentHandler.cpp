@@ -8,18 +8,19 @@
  * Author: Nico Kluge <klugenico@mailbox.org>
  */
 
+#include <cstring>
 #include "../ComponentHandler.h"
 
 namespace sEcs {
 
-    PointingComponentHandle::PointingComponentHandle(size_t typeSize, void(* deleteFunc)(void*)) :
-        deleteFunc(deleteFunc), typeSize(typeSize),
-        components(std::vector<void*>(MAX_ENTITY_AMOUNT + 1)) {}
+    PointingComponentHandle::PointingComponentHandle(size_t typeSize, void(* destroyFunc)(void*), size_t alignment) :
+        destroyFunc(destroyFunc), allocator(typeSize, alignment) {}
 
     PointingComponentHandle::~PointingComponentHandle() {
-        for (auto& component : components) {
-            deleteFunc(component);
-            component = nullptr;
+        for (sEcs::EntityIndex i = 0; i < components.capacity(); i++) {
+            if (components[i] != nullptr && destroyFunc != nullptr)
+                destroyFunc(components[i]);
+            components[i] = nullptr;
         }
     }
 
@@ -28,30 +29,120 @@ namespace sEcs {
     }
 
     void* PointingComponentHandle::createComponent(sEcs::EntityIndex entityIndex) {
-        return components[entityIndex] = malloc(typeSize);
+        components.ensure(entityIndex);
+        return components[entityIndex] = allocator.allocate();
     }
 
     void PointingComponentHandle::destroyComponentIntern(sEcs::EntityIndex entityIndex) {
-        deleteFunc(getComponent(entityIndex));
+        if (destroyFunc != nullptr)
+            destroyFunc(getComponent(entityIndex));
+        allocator.deallocate(getComponent(entityIndex));
         components[entityIndex] = nullptr;
     }
 
 
     ValuedComponentHandle::ValuedComponentHandle(size_t typeSize, void(* destroyFunc)(void*)) :
             destroyFunc(destroyFunc), typeSize(typeSize) {
-        data = std::vector<char>((MAX_ENTITY_AMOUNT + 1) * typeSize);
+        trivialDestroy = destroyFunc == nullptr;
     }
 
     void* ValuedComponentHandle::getComponent(sEcs::EntityIndex entityIndex) {
-        return &data[entityIndex * typeSize];
+        return &pages[entityIndex / ENTITY_PAGE_SIZE][(entityIndex % ENTITY_PAGE_SIZE) * typeSize];
     }
 
     void* ValuedComponentHandle::createComponent(sEcs::EntityIndex entityIndex) {
-        return &data[entityIndex * typeSize];
+        while (pages.size() <= entityIndex / ENTITY_PAGE_SIZE)
+            pages.emplace_back(new char[ENTITY_PAGE_SIZE * typeSize]);
+        return getComponent(entityIndex);
     }
 
     void ValuedComponentHandle::destroyComponentIntern(sEcs::EntityIndex entityIndex) {
         destroyFunc(getComponent(entityIndex));
     }
 
+
+
+    SparseSetComponentHandle::SparseSetComponentHandle(size_t typeSize, void(* destroyFunc)(void*),
+            void(* moveFunc)(void* destination, void* source)) :
+            typeSize(typeSize), destroyFunc(destroyFunc), moveFunc(moveFunc) {}
+
+    SparseSetComponentHandle::~SparseSetComponentHandle() {
+        for (sEcs::uint32 i = 0; destroyFunc != nullptr && i < getAmount(); i++)
+            destroyFunc(getDenseComponent(i));
+        operator delete(data);
+    }
+
+    void* SparseSetComponentHandle::getComponent(sEcs::EntityIndex entityIndex) {
+        return getDenseComponent(sparse[entityIndex] - 1);
+    }
+
+    void* SparseSetComponentHandle::createComponent(sEcs::EntityIndex entityIndex) {
+        sparse.ensure(entityIndex);
+
+        if (getAmount() == capacity) {
+            sEcs::uint32 newCapacity = capacity == 0 ? 16 : capacity * 2;
+            auto* newData = static_cast<char*>(operator new(newCapacity * typeSize));
+            if (moveFunc == nullptr && data != nullptr)    // trivially copyable
+                std::memcpy(newData, data, getAmount() * typeSize);
+            for (sEcs::uint32 i = 0; moveFunc != nullptr && i < getAmount(); i++)
+                moveFunc(newData + i * typeSize, getDenseComponent(i));
+            operator delete(data);
+            data = newData;
+            capacity = newCapacity;
+        }
+
+        entityIndices.push_back(entityIndex);
+        sparse[entityIndex] = getAmount();
+        return getDenseComponent(getAmount() - 1);
+    }
+
+    void SparseSetComponentHandle::destroyComponentIntern(sEcs::EntityIndex entityIndex) {
+        sEcs::InternIndex denseIndex = sparse[entityIndex] - 1;
+        sEcs::InternIndex last = getAmount() - 1;
+
+        if (destroyFunc != nullptr)
+            destroyFunc(getDenseComponent(denseIndex));
+        if (denseIndex != last) {   // swap remove
+            if (moveFunc == nullptr)
+                std::memcpy(getDenseComponent(denseIndex), getDenseComponent(last), typeSize);
+            else
+                moveFunc(getDenseComponent(denseIndex), getDenseComponent(last));
+            entityIndices[denseIndex] = entityIndices[last];
+            sparse[entityIndices[denseIndex]] = denseIndex + 1;
+        }
+
+        entityIndices.pop_back();
+        sparse[entityIndex] = 0;
+    }
+
+
+    void* TagComponentHandle::getComponent(sEcs::EntityIndex) {
+        return &tag;
+    }
+
+    void* TagComponentHandle::createComponent(sEcs::EntityIndex) {
+        return &tag;
+    }
+
+    void TagComponentHandle::destroyComponentIntern(sEcs::EntityIndex) {}
+
+
+    ArchetypeComponentHandle::ArchetypeComponentHandle(
+            Core_Intern::ArchetypeStorage* storage, sEcs::ComponentId componentId, void(* destroyFunc)(void*)) :
+            storage(storage), componentId(componentId), destroyFunc(destroyFunc) {
+        trivialDestroy = destroyFunc == nullptr;
+    }
+
+    void* ArchetypeComponentHandle::getComponent(sEcs::EntityIndex entityIndex) {
+        return storage->getComponent(entityIndex, componentId);
+    }
+
+    void* ArchetypeComponentHandle::createComponent(sEcs::EntityIndex entityIndex) {
+        return storage->getComponent(entityIndex, componentId);
+    }
+
+    void ArchetypeComponentHandle::destroyComponentIntern(sEcs::EntityIndex entityIndex) {
+        destroyFunc(getComponent(entityIndex));
+    }
+
 }
\ No newline at end of file
@@ -12,75 +12,264 @@
 #include <algorithm>
 #include <stdexcept>
 #include "../Core.h"
+#include "../ComponentHandler.h"
 
 namespace sEcs {
 
     namespace Core_Intern {     // private
 
-        EntityState::EntityState() : version(INVALID), componentMask(ComponentBitset()) {}
-
-        EntityState::EntityState(EntityVersion version) : version(version) {}
-
-        EntityId EntityState::id(EntityIndex index) const { return {version, index}; }
-
-        ComponentBitset* EntityState::getComponentMask() { return &componentMask; }
-
         void EntityState::reset() {
             version++;
             componentMask.reset();
         }
 
 
-        EntitySet::EntitySet(std::vector<ComponentId> componentIds) :
+        EntitySet::EntitySet(std::vector<ComponentId> componentIds, std::vector<ComponentId> excludedIds) :
+                mask(ComponentBitset()),
+                excludeMask(ComponentBitset()),
                 componentIds(componentIds),
-                mask(ComponentBitset()) {
-            std::sort(componentIds.begin(), componentIds.end());
+                excludedIds(excludedIds) {
             mask.set(&componentIds);
+            excludeMask.set(&excludedIds);
             entities.push_back(INVALID);
-            entities.reserve(MAX_ENTITY_AMOUNT);
-            internIndices.reserve(MAX_ENTITY_AMOUNT);
-            freeInternIndices.reserve(MAX_ENTITY_AMOUNT);
         }
 
         void EntitySet::updateMembership(EntityIndex entityIndex, ComponentBitset *previous, ComponentBitset *recent) {
-            if (previous->contains(&mask)) {
-                if (recent->contains(&mask)) // nothing changed
+            if (isMember(previous)) {
+                if (isMember(recent)) // nothing changed
                     return;
 
-                freeInternIndices.push_back(internIndices[entityIndex]);
-                entities[internIndices[entityIndex]] = INVALID; // doesn't contain entity any more
-                internIndices[entityIndex] = INVALID;
+                remove(entityIndex);    // doesn't contain entity any more
                 return;
             }
 
-            if (!recent->contains(&mask)) // nothing changed
+            if (!isMember(recent)) // nothing changed
                 return;
 
             add(entityIndex);      // add entityId, because it's not added yet, but should be
         }
 
         void EntitySet::add(EntityIndex entityIndex) {
-            if (!freeInternIndices.empty()) {
-                internIndices[entityIndex] = freeInternIndices.back();
-                freeInternIndices.pop_back();
-                entities[internIndices[entityIndex]] = entityIndex;
-            } else {
-                entities.push_back(entityIndex);
-                internIndices[entityIndex] = entities.size() - 1;
+            entities.push_back(entityIndex);
+            internIndices.ensure(entityIndex);
+            internIndices[entityIndex] = entities.size() - 1;
+            amount++;
+        }
+
+        void EntitySet::add(const EntityId* entityIds, uint32 amount) {
+            if (amount == 0)
+                return;
+
+            EntityIndex maxIndex = 0;
+            for (uint32 i = 0; i < amount; i++)
+                maxIndex = std::max(maxIndex, entityIds[i].index);
+            internIndices.ensure(maxIndex);
+
+            if (entities.size() + amount > entities.capacity())     // keeps the growth geometric
+                entities.reserve(std::max<size_t>(entities.size() + amount, 2 * entities.capacity()));
+            for (uint32 i = 0; i < amount; i++) {
+                internIndices[entityIds[i].index] = entities.size();
+                entities.push_back(entityIds[i].index);
             }
+            this->amount += amount;
         }
 
-        bool EntitySet::concern(std::vector<ComponentId> *vector) {
-            if (componentIds.size() != vector->size())
-                return false;
-            for (size_t i = 0; i < componentIds.size(); ++i)
-                if (componentIds[i] != (*vector)[i])
-                    return false;
-            return true;
+        void EntitySet::remove(EntityIndex entityIndex) {
+            InternIndex internIndex = internIndices[entityIndex];
+            internIndices[entityIndex] = INVALID;
+            amount--;
+
+            if (runningIterations > 0) {   // filled after the iteration
+                entities[internIndex] = INVALID;
+                holes.push_back(internIndex);
+                return;
+            }
+
+            EntityIndex last = entities.back();    // swap remove
+            entities.pop_back();
+            if (internIndex < entities.size()) {
+                entities[internIndex] = last;
+                internIndices[last] = internIndex;
+            }
+        }
+
+        void EntitySet::remove(const EntityIndex* entityIndices, uint32 amount) {
+            uint32 members = 0;
+            for (uint32 i = 0; i < amount; i++)
+                if (contains(entityIndices[i]))
+                    members++;
+            if (members == 0)
+                return;
+
+            if (members == this->amount && runningIterations == 0) {    // without holes all entities are members
+                for (InternIndex internIndex = 1; internIndex < entities.size(); internIndex++)
+                    internIndices[entities[internIndex]] = INVALID;
+                entities.resize(1);
+                this->amount = 0;
+                return;
+            }
+
+            for (uint32 i = 0; i < amount; i++)
+                if (contains(entityIndices[i]))
+                    remove(entityIndices[i]);
+        }
+
+        void EntitySet::endIteration() {
+            if (--runningIterations > 0)
+                return;
+
+            for (InternIndex hole : holes) {
+                while (entities.back() == INVALID && entities.size() > 1)
+                    entities.pop_back();
+                if (hole >= entities.size())    // removed with the tail already
+                    continue;
+
+                EntityIndex last = entities.back();
+                entities[hole] = last;
+                internIndices[last] = hole;
+                entities.pop_back();
+            }
+            holes.clear();
+        }
+
+        bool EntitySet::concern(std::vector<ComponentId> *vector, std::vector<ComponentId> *excluded) {
+            return componentIds == *vector && excludedIds == *excluded;
+        }
+
+
+        uint32 SetIterator::beginPass() {
+            passed.clear();
+            for (EntityIndex entityIndex = next(); entityIndex != INVALID; entityIndex = next())
+                passed.push_back(entityIndex);
+            return passed.size();
+        }
+
+        void SetIterator::endPass() {
+            passed.clear();
+        }
+
+
+        uint32 EntitySetIterator::beginPass() {
+            entitySet->beginIteration();
+            return entitySet->getEnd() - 1;
+        }
+
+        void EntitySetIterator::endPass() {
+            entitySet->endIteration();
+        }
+
+        void EntitySetIterator::reset() {
+            if (iterator == INVALID)
+                return;
+            entitySet->endIteration();
+            iterator = INVALID;
+        }
+
+
+        ArchetypeSetIterator::ArchetypeSetIterator(ArchetypeStorage *storage, std::vector<ComponentId> componentIds,
+                                                   std::vector<ComponentId> excludedIds) :
+                storage(storage), componentIds(std::move(componentIds)), excludedIds(std::move(excludedIds)) {}
+
+        EntityIndex ArchetypeSetIterator::next() {
+            if (!running) {
+                updateMatching();
+                running = true;
+                matchingPosition = 0;
+                row = 0;
+                chunkAmount = 0;
+                position = 0;
+                storage->watch(this);
+            }
+
+            if (!snapshot) {
+                if (position < chunkAmount || nextChunk())
+                    return chunkEntities[position++];
+                reset();
+                return INVALID;
+            }
+
+            while (position < passing.size()) {
+                EntityIndex entityIndex = passing[position++];
+                ArchetypeId archetypeId = storage->getArchetypeId(entityIndex);
+                if (archetypeId >= matchingIds.size())     // moved into a new archetype
+                    updateMatching();
+                if (matchingIds[archetypeId])
+                    return entityIndex;
+            }
+
+            reset();
+            return INVALID;
+        }
+
+        bool ArchetypeSetIterator::nextChunk() {
+            row += chunkAmount;
+            for (; matchingPosition < matching.size(); matchingPosition++, row = 0) {
+                Archetype* archetype = storage->getArchetype(matching[matchingPosition]);
+                if (row < archetype->getAmount()) {
+                    chunkEntities = archetype->getEntities(row);
+                    chunkAmount = std::min(archetype->getChunkCapacity(), archetype->getAmount() - row);
+                    position = 0;
+                    return true;
+                }
+            }
+            chunkAmount = 0;
+            return false;
+        }
+
+        void ArchetypeSetIterator::reset() {
+            if (running && !snapshot)
+                storage->unwatch(this);
+            running = false;
+            snapshot = false;
+            passing.clear();
+        }
+
+        void ArchetypeSetIterator::beforeMigration() {
+            passing.assign(chunkEntities + position, chunkEntities + chunkAmount);
+            for (row += chunkAmount; matchingPosition < matching.size(); matchingPosition++, row = 0) {
+                Archetype* archetype = storage->getArchetype(matching[matchingPosition]);
+                for (; row < archetype->getAmount(); row += archetype->getChunkCapacity()) {
+                    const EntityIndex* entities = archetype->getEntities(row);
+                    passing.insert(passing.end(), entities,
+                                   entities + std::min(archetype->getChunkCapacity(), archetype->getAmount() - row));
+                }
+            }
+            snapshot = true;
+            position = 0;
+        }
+
+        const std::vector<ArchetypeId>& ArchetypeSetIterator::getMatching() {
+            updateMatching();
+            return matching;
+        }
+
+        uint32 ArchetypeSetIterator::getAmount() {
+            updateMatching();
+            uint32 amount = 0;
+            for (ArchetypeId archetypeId : matching)
+                amount += storage->getArchetype(archetypeId)->getAmount();
+            return amount;
+        }
+
+        void ArchetypeSetIterator::updateMatching() {
+            for (; checkedArchetypes < storage->getArchetypeAmount(); checkedArchetypes++) {
+                const std::vector<ComponentId>& archetypeIds = storage->getArchetype(checkedArchetypes)->getComponentIds();
+                if (std::includes(archetypeIds.begin(), archetypeIds.end(), componentIds.begin(), componentIds.end())
+                        && std::find_first_of(archetypeIds.begin(), archetypeIds.end(),
+                                              excludedIds.begin(), excludedIds.end()) == archetypeIds.end()) {
+                    matching.push_back(checkedArchetypes);
+                    matchingIds.push_back(true);
+                } else {
+                    matchingIds.push_back(false);
+                }
+            }
         }
 
-        uint32 EntitySet::getVagueAmount() {
-            return entities.size() - freeInternIndices.size();
+
+        void ChangeTracking::prune(uint32 tick) {
+            auto kept = std::find_if(removals.begin(), removals.end(),
+                                     [tick](const ComponentRemoval& removal) { return removal.tick >= tick; });
+            removals.erase(removals.begin(), kept);
         }
 
     }      // end private
@@ -91,22 +280,29 @@ namespace sEcs {
     //////////////    Core    //////////////
     ////////////////////////////////////////
 
-    Core::Core() :
-            entities(std::vector<Core_Intern::EntityState>(MAX_ENTITY_AMOUNT + 1)) {
+    Core::Core(uint32 maxEntityAmount) :
+            maxEntityAmount(maxEntityAmount) {
         componentHandles.reserve(MAX_COMPONENT_AMOUNT + 1);
         componentHandles.push_back(nullptr);
+        componentSets.emplace_back();
+        changeTracking.emplace_back();
+        componentObservers.emplace_back();
+        observers.emplace_back();
+        entities.ensure(0);
         entities[0] = Core_Intern::EntityState();
 #if USE_ECS_EVENTS==1
         entityCreatedEventId_ = generateEvent();
         entityErasedEventId_ = generateEvent();
+        entitiesCreatedEventId_ = generateEvent();
+        entitiesErasedEventId_ = generateEvent();
 #endif
     }
 
 
     Core::~Core() {
         for (ComponentHandle *ch : componentHandles) delete ch;
-        for (Core_Intern::EntitySet *set : entitySets) delete set;
         for (Core_Intern::SetIterator *setIterator : setIterators) delete setIterator;
+        for (Core_Intern::EntitySet *set : entitySets) delete set;
     }
 
 
@@ -118,21 +314,124 @@ namespace sEcs {
             index = freeEntityIndices.back();
             freeEntityIndices.pop_back();
         } else {
+            if (lastEntityIndex >= maxEntityAmount)
+                return {};
             index = ++lastEntityIndex;
+            entities.ensure(index);
             entities[index] = Core_Intern::EntityState(EntityVersion(1));
         }
 
         EntityId entityId = entities[index].id(index);
 
 #if USE_ECS_EVENTS==1
-        auto event = Events::EntityCreatedEvent(entityId);
-        emitEvent(entityCreatedEventId_, &event);
+        if (hasListeners(entityCreatedEventId_)) {
+            auto event = Events::EntityCreatedEvent(entityId);
+            emitEvent(entityCreatedEventId_, &event);
+        }
 #endif
 
         return entityId;
     }
 
 
+    uint32 Core::createEntities(uint32 amount, EntityId* entityIds, const ComponentId* ids, size_t idsAmount) {
+
+        Core_Intern::ComponentBitset mask;
+        for (size_t i = 0; i < idsAmount; i++) {
+            if (mask.isSet(ids[i]))
+                throw std::invalid_argument("Each component can be passed only once");
+            mask.set(ids[i]);
+        }
+
+        // The component masks are written while taking the indices, unless listeners of single creations have to
+        // see the entities without components first
+        bool announced = false;
+#if USE_ECS_EVENTS==1
+        announced = hasListeners(entityCreatedEventId_);
+#endif
+        Core_Intern::ComponentBitset initial = announced ? Core_Intern::ComponentBitset() : mask;
+
+        uint32 created = 0;
+        for (; created < amount && !freeEntityIndices.empty(); created++) {
+            EntityIndex index = freeEntityIndices.back();
+            freeEntityIndices.pop_back();
+            Core_Intern::EntityState& state = entities[index];
+            state.componentMask = initial;
+            entityIds[created] = state.id(index);
+        }
+
+        uint32 available = lastEntityIndex < maxEntityAmount ? maxEntityAmount - lastEntityIndex : 0;
+        uint32 fresh = std::min(amount - created, available);
+        if (fresh > 0)
+            entities.ensure(lastEntityIndex + fresh);
+        for (uint32 i = 0; i < fresh; i++) {
+            EntityIndex index = ++lastEntityIndex;
+            Core_Intern::EntityState& state = entities[index];
+            state.version = 1;
+            state.componentMask = initial;
+            entityIds[created++] = state.id(index);
+        }
+
+#if USE_ECS_EVENTS==1
+        if (announced)
+            for (uint32 i = 0; i < created; i++) {
+                auto event = Events::EntityCreatedEvent(entityIds[i]);
+                emitEvent(entityCreatedEventId_, &event);
+            }
+#endif
+        if (announced && idsAmount > 0)
+            for (uint32 i = 0; i < created; i++)
+                *entities[entityIds[i].index].getComponentMask() = mask;
+
+        if (created > 0 && idsAmount > 0) {
+            if (!archetypeComponentIds.empty()) {
+                ArchetypeId target = 0;
+                for (ComponentId componentId : archetypeComponentIds)
+                    if (mask.isSet(componentId))
+                        target = archetypes.withComponent(target, componentId);
+                archetypes.migrate(entityIds, created, target);
+            }
+
+            for (size_t i = 0; i < idsAmount; i++) {
+                if (watched.isSet(ids[i]))
+                    recordWatched(entityIds, created, ids[i], true);
+                if (tags.isSet(ids[i]))
+                    continue;
+                componentHandles[ids[i]]->createComponents(entityIds, created);
+            }
+
+            // The same sets as updateAllMemberships would visit, each one gets all entities at once
+            Core_Intern::ComponentBitset empty;
+            uint64 stamp = ++membershipStamp;
+            empty.forEachDifference(&mask, [&](uint32 componentId) {
+                for (Core_Intern::EntitySet *set : componentSets[componentId])
+                    if (set->visit(stamp) && set->isMember(&mask))
+                        set->add(entityIds, created);
+            });
+        }
+
+#if USE_ECS_EVENTS==1
+        for (size_t i = 0; i < idsAmount; i++) {
+            ComponentEventInfo& info = componentHandles[ids[i]]->getComponentEventInfo();
+            EventId addEventId = info.addEventId;
+            if (!info.enabled || !hasListeners(addEventId))
+                continue;
+            for (uint32 j = 0; j < created; j++) {
+                auto event = Events::ComponentAddedEvent(entityIds[j]);
+                emitEvent(addEventId, entityIds[j].index, &event);
+            }
+        }
+
+        if (hasListeners(entitiesCreatedEventId_)) {
+            auto event = Events::EntitiesCreatedEvent(entityIds, created);
+            emitEvent(entitiesCreatedEventId_, &event);
+        }
+#endif
+
+        return created;
+    }
+
+
     bool Core::isValid(EntityId entityId) {
         return getIndex(entityId) != INVALID;
     }
@@ -144,24 +443,36 @@ namespace sEcs {
             return false;
 
 #if USE_ECS_EVENTS==1
-        auto eventErased = Events::EntityErasedEvent(entityId);
-        emitEvent(entityErasedEventId_, &eventErased);
+        if (hasListeners(entityErasedEventId_)) {
+            auto eventErased = Events::EntityErasedEvent(entityId);
+            emitEvent(entityErasedEventId_, index, &eventErased);
+        }
 #endif
 
         Core_Intern::ComponentBitset originally = *entities[index].getComponentMask();
 
+        for (ComponentId componentId : watchedComponentIds)
+            if (originally.isSet(componentId))
+                recordRemoved(entityId, componentId);
+
         for (ComponentId i = 1; i < componentHandles.size(); i++) {
             ComponentHandle *ch = componentHandles[i];
             if (originally.isSet(i)) {   // Only delete existing components
-                ch->destroyComponent(entityId, index);
+                if (!tags.isSet(i))
+                    ch->destroyComponent(entityId, index);
 #if USE_ECS_EVENTS == 1
-                auto event = Events::ComponentDeletedEvent(entityId);
-                emitEvent(ch->getComponentEventInfo().deleteEventId, &event);
+                emitDeletedEvent(entityId, ch);
 #endif
             }
         }
 
+#if USE_ECS_EVENTS==1
+        if (hasKeySubscriptions(index))
+            unsubscribeKey(index);
+#endif
+
         entities[index].reset();
+        updateArchetype(index, &originally, entities[index].getComponentMask());
         updateAllMemberships(entityId, &originally, entities[index].getComponentMask());
 
         freeEntityIndices.push_back(index);
@@ -170,7 +481,136 @@ namespace sEcs {
     }
 
 
-    ComponentId Core::registerComponent(ComponentHandle* ch) {
+    uint32 Core::eraseEntities(const EntityId* entityIds, uint32 amount) {
+
+        // The versions get increased while collecting, so duplicates are invalid already
+        std::vector<EntityIndex> indices;
+        indices.reserve(amount);
+        for (uint32 i = 0; i < amount; i++) {
+            EntityIndex index = getIndex(entityIds[i]);
+            if (index == INVALID)
+                continue;
+            indices.push_back(index);
+            entities[index].version++;
+        }
+        if (indices.empty())
+            return 0;
+        for (EntityIndex index : indices)
+            entities[index].version--;
+        uint32 amountErased = indices.size();
+
+#if USE_ECS_EVENTS==1
+        if (hasListeners(entityErasedEventId_) || hasListeners(entitiesErasedEventId_)) {
+            std::vector<EntityId> erased;
+            erased.reserve(indices.size());
+            for (EntityIndex index : indices)
+                erased.push_back(entities[index].id(index));
+            if (hasListeners(entityErasedEventId_))
+                for (EntityId entityId : erased) {
+                    auto event = Events::EntityErasedEvent(entityId);
+                    emitEvent(entityErasedEventId_, entityId.index, &event);
+                }
+            if (hasListeners(entitiesErasedEventId_)) {
+                auto erasedEvent = Events::EntitiesErasedEvent(&erased.front(), erased.size());
+                emitEvent(entitiesErasedEventId_, &erasedEvent);
+            }
+
+            // The listeners may have erased entities of the batch already, their indices may even be reused
+            indices.clear();
+            for (EntityId entityId : erased)
+                if (getIndex(entityId) != INVALID)
+                    indices.push_back(entityId.index);
+            if (indices.empty())
+                return amountErased;
+        }
+#endif
+
+        Core_Intern::ComponentBitset empty;
+        Core_Intern::ComponentBitset used;     // all components of the entities
+        for (EntityIndex index : indices)
+            used.unite(entities[index].getComponentMask());
+
+        for (ComponentId componentId : watchedComponentIds)
+            if (used.isSet(componentId))
+                for (EntityIndex index : indices)
+                    if (hasComponent(index, componentId))
+                        recordRemoved(entities[index].id(index), componentId);
+
+        // Components are destroyed per storage, storages which destroy nothing are skipped
+        std::vector<EntityIndex> owners;
+        empty.forEachDifference(&used, [&](uint32 componentId) {
+            bool tag = tags.isSet(componentId);
+            ComponentHandle* ch = componentHandles[componentId];
+            bool events = false;
+#if USE_ECS_EVENTS==1
+            events = ch->getComponentEventInfo().enabled && hasListeners(ch->getComponentEventInfo().deleteEventId);
+#endif
+            if ((tag || ch->destroysNothing()) && !events)
+                return;
+
+            owners.clear();
+            for (EntityIndex index : indices)
+                if (hasComponent(index, componentId))
+                    owners.push_back(index);
+            if (!tag)
+                ch->destroyComponents(owners.data(), owners.size());
+
+#if USE_ECS_EVENTS==1
+            if (events)
+                for (EntityIndex index : owners) {
+                    auto event = Events::ComponentDeletedEvent(entities[index].id(index));
+                    emitEvent(ch->getComponentEventInfo().deleteEventId, index, &event);
+                }
+#endif
+        });
+
+#if USE_ECS_EVENTS==1
+        for (EntityIndex index : indices)
+            if (hasKeySubscriptions(index))
+                unsubscribeKey(index);
+#endif
+
+        if (!archetypeComponentIds.empty())
+            for (EntityIndex index : indices)
+                if (archetypes.getArchetypeId(index) != 0)
+                    archetypes.migrate(index, 0);
+
+        uint64 stamp = ++membershipStamp;
+        empty.forEachDifference(&used, [&](uint32 componentId) {
+            for (Core_Intern::EntitySet *set : componentSets[componentId])
+                if (set->visit(stamp))
+                    set->remove(&indices.front(), indices.size());
+        });
+
+        for (EntityIndex index : indices)
+            entities[index].reset();
+        freeEntityIndices.insert(freeEntityIndices.end(), indices.begin(), indices.end());
+
+        return amountErased;
+    }
+
+
+    uint32 Core::clearQuery(SetIteratorId setIteratorId) {
+        return clearQuery(*setIterators[setIteratorId]);
+    }
+
+    uint32 Core::clearQuery(Core_Intern::SetIterator& setIterator) {
+        std::vector<EntityId> members;
+        {
+            Core_Intern::PassGuard pass(&setIterator);
+            members.reserve(pass.getEnd());
+            for (uint32 position = 0; position < pass.getEnd(); position++) {
+                EntityIndex index = setIterator.at(position);
+                if (index != INVALID)
+                    members.push_back(entities[index].id(index));
+            }
+        }
+
+        return members.empty() ? 0 : eraseEntities(&members.front(), members.size());
+    }
+
+
+    ComponentId Core::registerComponent(ComponentHandle* ch, ComponentTraits traits) {
 
         if (componentHandles.size() >= MAX_COMPONENT_AMOUNT) {
             throw std::length_error("To many component types registered! Define by MAX_COMPONENT_AMOUNT.");
@@ -180,12 +620,34 @@ namespace sEcs {
         ComponentEventInfo& componentInfo = ch->getComponentEventInfo();
         componentInfo.addEventId = generateEvent();
         componentInfo.deleteEventId = generateEvent();
+        componentInfo.replaceEventId = generateEvent();
 #endif
+        ch->getTraits() = traits;
         componentHandles.push_back(ch);
+        componentSets.emplace_back();
+        changeTracking.emplace_back();
+        componentObservers.emplace_back();
 
         return componentHandles.size() - 1;
     }
 
+    ComponentId Core::registerArchetypeComponent(size_t typeSize, size_t alignment,
+            void(* destroyFunc)(void*), void(* moveFunc)(void* destination, void* source), ComponentTraits traits) {
+
+        auto componentId = static_cast<ComponentId>(componentHandles.size());
+        archetypes.registerComponent(componentId, typeSize, alignment, destroyFunc, moveFunc);   // may reject it
+        registerComponent(new ArchetypeComponentHandle(&archetypes, componentId, destroyFunc), traits);
+        archetypeComponentIds.push_back(componentId);
+
+        return componentId;
+    }
+
+    ComponentId Core::registerTagComponent() {
+        ComponentId componentId = registerComponent(new TagComponentHandle());
+        tags.set(componentId);
+        return componentId;
+    }
+
     void* Core::addComponent(EntityId entityId, ComponentId componentId) {
 
         EntityIndex index = getIndex(entityId);
@@ -195,64 +657,119 @@ namespace sEcs {
         ComponentHandle* ch = componentHandles[componentId];
         Core_Intern::ComponentBitset originally = *entities[index].getComponentMask();
 
+        if (tags.isSet(componentId)) {   // Tags only exist in the component mask
+            if (!originally.isSet(componentId)) {
+                entities[index].getComponentMask()->set(componentId);
+                recordAdded(entityId, componentId);
+                updateAllMemberships(entityId, &originally, entities[index].getComponentMask());
+            }
+#if USE_ECS_EVENTS == 1
+            if (originally.isSet(componentId))
+                emitReplaceEvents(entityId, ch);
+            else
+                emitAddedEvent(entityId, ch);
+#endif
+            return ch->getComponent(index);
+        }
+
         if (!originally.isSet( componentId )) {   // Only update if component type is new for entity
             entities[index].getComponentMask()->set( componentId );
+            recordAdded(entityId, componentId);
+            updateArchetype(index, &originally, entities[index].getComponentMask());
             updateAllMemberships(entityId, &originally, entities[index].getComponentMask());
+        } else if (ch->getTraits().triviallyCopyable) {     // overwrite in place
+            markChanged(index, componentId);
+#if USE_ECS_EVENTS == 1
+            emitReplaceEvents(entityId, ch);
+#endif
+            return ch->getComponent(index);
         } else {
+            markChanged(index, componentId);
             ch->destroyComponent(entityId, index);
 #if USE_ECS_EVENTS == 1
-            auto event = Events::ComponentDeletedEvent(entityId);
-            emitEvent(ch->getComponentEventInfo().deleteEventId, &event);
+            emitDeletedEvent(entityId, ch);
 #endif
         }
 
         void* comp = ch->createComponent(index);
 
 #if USE_ECS_EVENTS==1
-        auto event = Events::ComponentAddedEvent(entityId);
-        emitEvent(ch->getComponentEventInfo().addEventId, &event);
+        emitAddedEvent(entityId, ch);
 #endif
 
         return comp;
     }
 
 
-    // OptimizeAble
     bool Core::activateComponents(EntityId entityId, const ComponentId* ids, size_t idsAmount) {
+        return changeComponents(entityId, ids, idsAmount, nullptr, 0);
+    }
+
+
+    bool Core::changeComponents(EntityId entityId, const ComponentId* addedIds, size_t addedAmount,
+                                const ComponentId* deletedIds, size_t deletedAmount) {
 
         EntityIndex index = getIndex(entityId);
         if (index == INVALID)
             return false;
 
         Core_Intern::ComponentBitset originally = *entities[index].getComponentMask();
+        Core_Intern::ComponentBitset* recent = entities[index].getComponentMask();
 
         bool modified = false;
-        for (uint32 i = 0; i < idsAmount; i++) {
-            ComponentHandle* ch = componentHandles[ids[i]];
-            if (originally.isSet(ids[i])) {
+        for (uint32 i = 0; i < deletedAmount; i++) {
+            if (!originally.isSet(deletedIds[i]))
+                continue;
+            recordRemoved(entityId, deletedIds[i]);
+            ComponentHandle* ch = componentHandles[deletedIds[i]];
+            if (!tags.isSet(deletedIds[i]))
                 ch->destroyComponent(entityId, index);
 #if USE_ECS_EVENTS == 1
-                auto event = Events::ComponentDeletedEvent(entityId);
-                emitEvent(ch->getComponentEventInfo().deleteEventId, &event);
+            emitDeletedEvent(entityId, ch);
 #endif
-            }
-            else
-                modified = true;
+            recent->unset(deletedIds[i]);
+            modified = true;
         }
 
-        if (modified) {   // Only update if component types are new for entity
-
-            for (uint32 i = 0; i < idsAmount; i++)
-                entities[index].getComponentMask()->set(ids[i]);
+        for (uint32 i = 0; i < addedAmount; i++)
+            if (!originally.isSet(addedIds[i])) {
+                recent->set(addedIds[i]);
+                recordAdded(entityId, addedIds[i]);
+                modified = true;
+            } else {
+                markChanged(index, addedIds[i]);
+            }
 
-            updateAllMemberships(entityId, &originally, entities[index].getComponentMask());
+        // Archetype stored components have to be moved before replaced ones get destroyed
+        if (modified)
+            updateArchetype(index, &originally, recent);
+
+        for (uint32 i = 0; i < addedAmount; i++) {
+            if (tags.isSet(addedIds[i]))
+                continue;
+            ComponentHandle* ch = componentHandles[addedIds[i]];
+            if (originally.isSet(addedIds[i])) {
+                if (ch->getTraits().triviallyCopyable)   // overwrite in place
+                    continue;
+                ch->destroyComponent(entityId, index);
+#if USE_ECS_EVENTS == 1
+                emitDeletedEvent(entityId, ch);
+#endif
+            }
+            ch->createComponent(index);
         }
 
+        if (modified)   // Only update if the component types of the entity changed
+            updateAllMemberships(entityId, &originally, recent);
+
 #if USE_ECS_EVENTS==1
-        for (uint32 i = 0; i < idsAmount; i++) {
-            ComponentHandle* ch = componentHandles[ids[i]];
-            auto event = Events::ComponentAddedEvent(entityId);
-            emitEvent(ch->getComponentEventInfo().addEventId, &event);
+        for (uint32 i = 0; i < addedAmount; i++) {
+            ComponentHandle* ch = componentHandles[addedIds[i]];
+            if (originally.isSet(addedIds[i]) && (ch->getTraits().triviallyCopyable || tags.isSet(addedIds[i]))) {
+                emitReplaceEvents(entityId, ch);
+                continue;
+            }
+            emitAddedEvent(entityId, ch);
         }
 #endif
 
@@ -281,13 +798,15 @@ namespace sEcs {
         Core_Intern::ComponentBitset originally = *entities[index].getComponentMask();
 
         if (originally.isSet(componentId)) {
+            recordRemoved(entityId, componentId);
             auto* ch = componentHandles[componentId];
-            ch->destroyComponent(entityId, index);
+            if (!tags.isSet(componentId))
+                ch->destroyComponent(entityId, index);
 #if USE_ECS_EVENTS == 1
-            auto event = Events::ComponentDeletedEvent(entityId);
-            emitEvent(ch->getComponentEventInfo().deleteEventId, &event);
+            emitDeletedEvent(entityId, ch);
 #endif
             entities[index].getComponentMask()->unset( componentId );
+            updateArchetype(index, &originally, entities[index].getComponentMask());
             updateAllMemberships(entityId, &originally, entities[index].getComponentMask());
             return true;
         }
@@ -296,6 +815,126 @@ namespace sEcs {
     }
 
 
+    void Core::trackChanges(ComponentId componentId) {
+        if (changeTracking[componentId] != nullptr)
+            return;
+
+        // Existing components get tick 0, so only the first pass of a query counts them as added or changed
+        changeTracking[componentId].reset(new Core_Intern::ChangeTracking());
+        changeTracking[componentId]->ensure(lastEntityIndex);
+        watch(componentId);
+    }
+
+    void Core::pruneRemovals(uint32 tick) {
+        for (ComponentId componentId : watchedComponentIds)
+            if (changeTracking[componentId] != nullptr)
+                changeTracking[componentId]->prune(tick);
+    }
+
+
+    ObserverId Core::observe(ComponentId componentId, Core_Intern::ObserverCallback onAdded,
+                             Core_Intern::ObserverCallback onRemoved) {
+        auto* observer = new Core_Intern::Observer();
+        observer->componentId = componentId;
+        observer->onAdded = std::move(onAdded);
+        observer->onRemoved = std::move(onRemoved);
+        observers.emplace_back(observer);
+        componentObservers[componentId].push_back(observer);
+        watch(componentId);
+        return observers.size() - 1;
+    }
+
+    void Core::unobserve(ObserverId observerId) {
+        if (observerId == INVALID || observerId >= observers.size() || observers[observerId] == nullptr)
+            return;
+
+        ComponentId componentId = observers[observerId]->componentId;
+        std::vector<Core_Intern::Observer*>& v = componentObservers[componentId];
+        v.erase(std::remove(v.begin(), v.end(), observers[observerId].get()), v.end());
+
+        if (v.empty() && changeTracking[componentId] == nullptr) {     // nothing left to record
+            watched.unset(componentId);
+            watchedComponentIds.erase(
+                    std::remove(watchedComponentIds.begin(), watchedComponentIds.end(), componentId),
+                    watchedComponentIds.end());
+        }
+
+        // A callback may remove its own observer
+        if (delivering)
+            retiredObservers.push_back(std::move(observers[observerId]));
+        observers[observerId].reset();
+    }
+
+    void Core::deliverObservations() {
+        if (delivering)
+            return;
+        delivering = true;
+
+        // Observers added by the callbacks have nothing to deliver yet
+        ObserverId amount = observers.size();
+        for (ObserverId id = 1; id < amount; id++)
+            if (observers[id] != nullptr) {
+                observers[id]->deliveredAdded.swap(observers[id]->added);
+                observers[id]->deliveredRemoved.swap(observers[id]->removed);
+            }
+
+        try {
+            for (ObserverId id = 1; id < amount; id++) {
+                Core_Intern::Observer* observer = observers[id].get();
+                if (observer != nullptr && !observer->deliveredAdded.empty())
+                    observer->onAdded(&observer->deliveredAdded.front(), observer->deliveredAdded.size());
+            }
+            for (ObserverId id = 1; id < amount; id++) {
+                Core_Intern::Observer* observer = observers[id].get();
+                if (observer != nullptr && !observer->deliveredRemoved.empty())
+                    observer->onRemoved(&observer->deliveredRemoved.front(), observer->deliveredRemoved.size());
+            }
+        } catch (...) {
+            finishDelivery(amount);
+            throw;
+        }
+
+        finishDelivery(amount);
+    }
+
+    void Core::finishDelivery(ObserverId amount) {
+        for (ObserverId id = 1; id < amount; id++)
+            if (observers[id] != nullptr) {
+                observers[id]->deliveredAdded.clear();
+                observers[id]->deliveredRemoved.clear();
+            }
+        delivering = false;
+        retiredObservers.clear();
+    }
+
+
+    void Core::recordWatched(const EntityId* entityIds, uint32 amount, ComponentId componentId, bool added) {
+        Core_Intern::ChangeTracking* tracking = changeTracking[componentId].get();
+        if (tracking != nullptr) {
+            uint32 tick = getChangeTick();
+            for (uint32 i = 0; i < amount; i++)
+                if (added)
+                    tracking->add(entityIds[i].index, tick);
+                else
+                    tracking->remove(entityIds[i], tick);
+        }
+
+        for (Core_Intern::Observer* observer : componentObservers[componentId]) {
+            if (added ? !observer->onAdded : !observer->onRemoved)
+                continue;
+            std::vector<EntityId>& collected = added ? observer->added : observer->removed;
+            collected.insert(collected.end(), entityIds, entityIds + amount);
+        }
+    }
+
+    void Core::watch(ComponentId componentId) {
+        if (watched.isSet(componentId))
+            return;
+        watched.set(componentId);
+        watchedComponentIds.push_back(componentId);
+    }
+
+
 #if USE_ECS_EVENTS == 1
 
     EventId Core::componentDeletedEventId(ComponentId componentId) {
@@ -308,6 +947,30 @@ namespace sEcs {
         return ch->getComponentEventInfo().addEventId;
     }
 
+    EventId Core::componentReplacedEventId(ComponentId componentId) {
+        auto* ch = componentHandles[componentId];
+        return ch->getComponentEventInfo().replaceEventId;
+    }
+
+    void Core::setReplaceEvents(ComponentId componentId, bool replaceEvents) {
+        componentHandles[componentId]->getComponentEventInfo().replaceEvents = replaceEvents;
+    }
+
+    void Core::setComponentEvents(ComponentId componentId, bool enabled) {
+        componentHandles[componentId]->getComponentEventInfo().enabled = enabled;
+    }
+
+    void Core::emitReplaceEvents(EntityId entityId, ComponentHandle* ch) {
+        ComponentEventInfo& info = ch->getComponentEventInfo();
+        if (!info.replaceEvents) {
+            emitDeletedEvent(entityId, ch);
+            emitAddedEvent(entityId, ch);
+        } else if (info.enabled && hasListeners(info.replaceEventId)) {
+            auto event = Events::ComponentReplacedEvent(entityId);
+            emitEvent(info.replaceEventId, entityId.index, &event);
+        }
+    }
+
     EventId Core::entityCreatedEventId() {
         return entityCreatedEventId_;
     }
@@ -316,39 +979,122 @@ namespace sEcs {
         return entityErasedEventId_;
     }
 
+    EventId Core::entitiesCreatedEventId() {
+        return entitiesCreatedEventId_;
+    }
+
+    EventId Core::entitiesErasedEventId() {
+        return entitiesErasedEventId_;
+    }
+
+    Events::Subscription Core::subscribeEntityEvent(EventId eventId, EntityId entityId, Events::Delegate delegate) {
+        EntityIndex index = getIndex(entityId);
+        if (index == INVALID)
+            return Events::Subscription();
+        return subscribeEvent(eventId, index, delegate);
+    }
+
+    Events::Subscription Core::subscribeEntityEvent(EventId eventId, std::vector<ComponentId> componentIds,
+                                                    std::vector<ComponentId> excludedIds, Events::Delegate delegate) {
+        if (!isEntityEvent(eventId))
+            throw std::invalid_argument("Only component events and the erased event can be filtered by a query");
+        std::unique_ptr<QueryDelegate> query(new QueryDelegate{this, {}, {}, delegate, {}});
+        query->mask.set(&componentIds);
+        query->excludeMask.set(&excludedIds);
+        query->subscription = subscribeEvent(eventId, Events::Delegate{&Core::emitFiltered, query.get()});
+        queryDelegates.push_back(std::move(query));
+        return queryDelegates.back()->subscription;
+    }
+
+    void Core::unsubscribeEvent(Events::Subscription subscription) {
+        Events::EventHandler::unsubscribeEvent(subscription);
+        for (auto& query : queryDelegates) {
+            const Events::Subscription& own = query->subscription;
+            if (own.eventId == subscription.eventId && own.key == subscription.key
+                && own.handle == subscription.handle && own.generation == subscription.generation) {
+                query = std::move(queryDelegates.back());   // its delegate is cleared already
+                queryDelegates.pop_back();
+                return;
+            }
+        }
+    }
+
+    void Core::emitFiltered(void* context, const void* event) {
+        auto* query = static_cast<QueryDelegate*>(context);
+        // All events of one entity start with its id
+        EntityIndex index = static_cast<const Events::ComponentAddedEvent*>(event)->entityId.index;
+        Core_Intern::ComponentBitset* components = query->core->entities[index].getComponentMask();
+        if (components->contains(&query->mask) && !components->intersects(&query->excludeMask))
+            query->delegate.function(query->delegate.context, event);
+    }
+
+    bool Core::isEntityEvent(EventId eventId) {
+        if (eventId == entityErasedEventId_)
+            return true;
+        for (ComponentId i = 1; i < componentHandles.size(); i++) {
+            ComponentEventInfo& info = componentHandles[i]->getComponentEventInfo();
+            if (eventId == info.addEventId || eventId == info.deleteEventId || eventId == info.replaceEventId)
+                return true;
+        }
+        return false;
+    }
+
 #endif
 
 
-    SetIteratorId Core::createSetIterator(std::vector<ComponentId> componentIds) {
+    SetIteratorId Core::createSetIterator(std::vector<ComponentId> componentIds, std::vector<ComponentId> excludedIds) {
+        setIterators.push_back(makeSetIterator(std::move(componentIds), std::move(excludedIds)).release());
+        return static_cast<SetIteratorId>(setIterators.size() - 1);
+    }
+
+    std::unique_ptr<Core_Intern::SetIterator> Core::makeSetIterator(std::vector<ComponentId> componentIds,
+                                                                    std::vector<ComponentId> excludedIds) {
 
         std::sort(componentIds.begin(), componentIds.end());
+        std::sort(excludedIds.begin(), excludedIds.end());
+
+        bool archetypeStored = !componentIds.empty();
+        for (ComponentId componentId : componentIds)
+            if (!archetypes.isStored(componentId))
+                archetypeStored = false;
+        for (ComponentId componentId : excludedIds)
+            if (!archetypes.isStored(componentId))
+                archetypeStored = false;
+
+        if (archetypeStored)    // No EntitySet needed, the archetypes are organizing the entities already
+            return std::unique_ptr<Core_Intern::SetIterator>(
+                    new Core_Intern::ArchetypeSetIterator(&archetypes, componentIds, excludedIds));
+
         Core_Intern::EntitySet *entitySet = nullptr;
 
         for (Core_Intern::EntitySet *set : entitySets)
-            if (set->concern(&componentIds))
+            if (set->concern(&componentIds, &excludedIds))
                 entitySet = set;
 
         if (entitySet == nullptr) {
-            entitySet = new Core_Intern::EntitySet(componentIds);
+            entitySet = new Core_Intern::EntitySet(componentIds, excludedIds);
             entitySets.push_back(entitySet);
+            for (ComponentId componentId : componentIds)
+                componentSets[componentId].push_back(entitySet);
+            for (ComponentId componentId : excludedIds)
+                componentSets[componentId].push_back(entitySet);
 
             // add all related Entities
             for (EntityIndex entityIndex = 1; entityIndex <= lastEntityIndex; entityIndex++)
                 entitySet->dumbAddIfMember(entities[entityIndex].id(entityIndex), entities[entityIndex].getComponentMask());
         }
 
-        setIterators.push_back(new Core_Intern::SetIterator(entitySet));
-        return static_cast<SetIteratorId>(setIterators.size() - 1);
+        return std::unique_ptr<Core_Intern::SetIterator>(new Core_Intern::EntitySetIterator(entitySet));
     }
 
     uint32 Core::getEntityAmount(SetIteratorId setIteratorId) {
-        return setIterators[setIteratorId]->getEntitySet()->getVagueAmount();
+        return setIterators[setIteratorId]->getAmount();
     }
 
     uint32 Core::getEntityAmount(std::vector<ComponentId>& componentIds) {
         static SetIteratorId setIteratorId = createSetIterator(componentIds);
         while (nextEntity(setIteratorId).version != INVALID);
-        return setIterators[setIteratorId]->getEntitySet()->getVagueAmount();
+        return setIterators[setIteratorId]->getAmount();
     }
 
     EntityId Core::getIdFromIndex(EntityIndex index) {
@@ -358,9 +1104,30 @@ namespace sEcs {
     }
 
     void Core::updateAllMemberships(EntityId entityId, Core_Intern::ComponentBitset *previous, Core_Intern::ComponentBitset *recent) {
-        for (Core_Intern::EntitySet *set : entitySets) {
-            set->updateMembership(entityId.index, previous, recent);
+        // Only sets with a changed component in their mask can change. Sets with several changed components
+        // are visited once per update.
+        uint64 stamp = ++membershipStamp;
+        previous->forEachDifference(recent, [&](uint32 componentId) {
+            for (Core_Intern::EntitySet *set : componentSets[componentId])
+                if (set->visit(stamp))
+                    set->updateMembership(entityId.index, previous, recent);
+        });
+    }
+
+    void Core::updateArchetype(EntityIndex entityIndex, Core_Intern::ComponentBitset *previous, Core_Intern::ComponentBitset *recent) {
+        if (archetypeComponentIds.empty())
+            return;
+
+        ArchetypeId archetypeId = archetypes.getArchetypeId(entityIndex);
+        ArchetypeId target = archetypeId;
+        for (ComponentId componentId : archetypeComponentIds) {
+            bool wanted = recent->isSet(componentId);
+            if (wanted != previous->isSet(componentId))
+                target = wanted ? archetypes.withComponent(target, componentId) : archetypes.withoutComponent(target, componentId);
         }
+
+        if (target != archetypeId)
+            archetypes.migrate(entityIndex, target);
     }
 
 }
\ No newline at end of file
@@ -9,11 +9,12 @@
  */
 
 
+#include <atomic>
 #include "../EcsManager.h"
 
 namespace sEcs {
 
-    EcsManager::EcsManager() {
+    EcsManager::EcsManager(uint32 maxEntityAmount) : Core(maxEntityAmount) {
         systems.emplace_back(nullptr);
         objects.emplace_back(nullptr);
         pointers.emplace_back(nullptr);
@@ -31,11 +32,36 @@ namespace sEcs {
     }
 
 
-    ComponentId EcsManager::registerComponent(const std::string& componentName, ComponentHandle* ch) {
+    ComponentId EcsManager::registerComponent(const std::string& componentName, ComponentHandle* ch,
+            ComponentTraits traits) {
         if (getIdByName<ConceptType::COMPONENT>(componentName) != 0)
             throw std::invalid_argument ("Component already existing: " + componentName);
 
-        ComponentId componentId = registerComponent(ch);
+        ComponentId componentId = registerComponent(ch, traits);
+        conceptRegisters[ConceptType::COMPONENT].set(componentName, componentId);
+
+        return componentId;
+    }
+
+
+    ComponentId EcsManager::registerArchetypeComponent(const std::string& componentName, size_t typeSize,
+            size_t alignment, void(* destroyFunc)(void*), void(* moveFunc)(void* destination, void* source),
+            ComponentTraits traits) {
+        if (getIdByName<ConceptType::COMPONENT>(componentName) != 0)
+            throw std::invalid_argument ("Component already existing: " + componentName);
+
+        ComponentId componentId = registerArchetypeComponent(typeSize, alignment, destroyFunc, moveFunc, traits);
+        conceptRegisters[ConceptType::COMPONENT].set(componentName, componentId);
+
+        return componentId;
+    }
+
+
+    ComponentId EcsManager::registerTagComponent(const std::string& componentName) {
+        if (getIdByName<ConceptType::COMPONENT>(componentName) != 0)
+            throw std::invalid_argument ("Component already existing: " + componentName);
+
+        ComponentId componentId = registerTagComponent();
         conceptRegisters[ConceptType::COMPONENT].set(componentName, componentId);
 
         return componentId;
@@ -73,9 +99,95 @@ namespace sEcs {
 
 
     void EcsManager::update(DELTA_TYPE delta) {
-        for (uint32 i = 1; i < systems.size(); i++) {
-            systems[i]->update(delta);
+        // Removals stay visible during the update after the one they happened in
+        pruneRemovals(previousUpdateTick);
+        previousUpdateTick = getChangeTick();
+
+        // The changes since the previous update, before the systems change anything
+        deliverObservations();
+
+        if (parallelUpdate && systems.size() > 2) {
+            updateParallel(delta);
+        } else {
+            for (uint32 i = 1; i < systems.size(); i++) {
+                systems[i]->update(delta);
+            }
         }
+
+        dispatchQueued();
+    }
+
+
+    void EcsManager::setParallelUpdate(bool parallel, uint32 threadAmount) {
+        parallelUpdate = parallel;
+        if (!parallel)
+            return;
+        if (jobSystem == nullptr || (threadAmount != 0 && threadAmount != jobSystem->getThreadAmount())) {
+            jobSystem.reset(new JobSystem(threadAmount));
+            reserveProducers(jobSystem->getThreadAmount() + 1);
+        }
+    }
+
+
+    JobSystem& EcsManager::getJobSystem() {
+        if (jobSystem == nullptr) {
+            jobSystem.reset(new JobSystem());
+            reserveProducers(jobSystem->getThreadAmount() + 1);
+        }
+        return *jobSystem;
+    }
+
+
+    namespace {
+
+        struct ParallelFrame {
+            std::vector<std::shared_ptr<System>>* systems;
+            JobSystem* jobSystem;
+            JobCounter counter;
+            DELTA_TYPE delta;
+
+            std::vector<std::vector<uint32>> dependents;
+            std::unique_ptr<std::atomic<uint32>[]> dependencies;
+        };
+
+        // Systems depending on a failed one are skipped
+        void runSystem(ParallelFrame& frame, uint32 i) {
+            (*frame.systems)[i]->update(frame.delta);
+
+            for (uint32 dependent : frame.dependents[i])
+                if (--frame.dependencies[dependent] == 0)
+                    frame.jobSystem->submit([&frame, dependent]() { runSystem(frame, dependent); }, frame.counter);
+        }
+
+    }
+
+
+    void EcsManager::updateParallel(DELTA_TYPE delta) {
+        uint32 amount = systems.size();
+
+        ParallelFrame frame;
+        frame.systems = &systems;
+        frame.jobSystem = &getJobSystem();
+        frame.delta = delta;
+
+        // Each system depends on all earlier added systems it conflicts with
+        std::vector<uint32> roots;
+        frame.dependents.resize(amount);
+        frame.dependencies.reset(new std::atomic<uint32>[amount]);
+        for (uint32 i = 1; i < amount; i++) {
+            frame.dependencies[i] = 0;
+            for (uint32 j = 1; j < i; j++)
+                if (systems[i]->getAccess().conflicts(systems[j]->getAccess())) {
+                    frame.dependents[j].push_back(i);
+                    frame.dependencies[i]++;
+                }
+            if (frame.dependencies[i] == 0)
+                roots.push_back(i);
+        }
+
+        for (uint32 root : roots)
+            frame.jobSystem->submit([&frame, root]() { runSystem(frame, root); }, frame.counter);
+        frame.jobSystem->wait(frame.counter);
     }
 
 }
\ No newline at end of file
@@ -12,34 +12,361 @@
 #include "../EventHandler.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
 
 namespace sEcs {
     namespace Events {
 
+        EventProducer::EventProducer() : tail(new Block(PRODUCER_BLOCK_SIZE)), head(tail) {}
+
+        EventProducer::~EventProducer() {
+            consume([](const Header& header, void* event) {
+                if (header.destroyFunc != nullptr)
+                    header.destroyFunc(event);
+            });
+            delete head;
+            delete spare.load();
+        }
+
+        void* EventProducer::enqueueEvent(EventId eventId, size_t size, size_t alignment,
+                                          void(* moveFunc)(void*, void*), void(* destroyFunc)(void*)) {
+            if (alignment > alignof(std::max_align_t))
+                throw std::invalid_argument("Queued events can't be over-aligned");
+
+            auto align = [](size_t offset, size_t alignment) { return (offset + alignment - 1) & ~(alignment - 1); };
+            size_t header = align(used, alignof(Header));
+            size_t event = align(header + sizeof(Header), alignment);
+            if (event + size > tail->size) {    // the consumer may delete the old block from now on
+                size_t needed = sizeof(Header) + alignment + size;
+                Block* block = spare.exchange(nullptr, std::memory_order_acquire);
+                if (block == nullptr || block->size < needed) {
+                    delete block;
+                    block = new Block(std::max<size_t>(PRODUCER_BLOCK_SIZE, needed));
+                }
+                block->published.store(0, std::memory_order_relaxed);
+                block->next.store(nullptr, std::memory_order_relaxed);
+                tail->next.store(block, std::memory_order_release);
+                tail = block;
+                header = 0;
+                event = align(sizeof(Header), alignment);
+            }
+
+            used = event + size;
+            new (tail->data.get() + header) Header{eventId, static_cast<uint32>(event), static_cast<uint32>(size),
+                                                   moveFunc, destroyFunc};
+            return tail->data.get() + event;
+        }
+
+        template<typename Func>
+        void EventProducer::consume(Func func) {
+            while (true) {
+                // The producer publishes all events of a block before it links the next one
+                Block* next = head->next.load(std::memory_order_acquire);
+                size_t published = head->published.load(std::memory_order_acquire);
+                while (read < published) {
+                    auto* header = reinterpret_cast<Header*>(head->data.get() + read);
+                    func(*header, head->data.get() + header->event);
+                    read = (header->event + header->size + alignof(Header) - 1) & ~(alignof(Header) - 1);
+                }
+                if (next == nullptr)
+                    return;
+                delete spare.exchange(head, std::memory_order_release);
+                head = next;
+                read = 0;
+            }
+        }
+
+
         EventHandler::EventHandler() {
             listeners.emplace_back();
+            delegates.emplace_back();
+            subscribers.push_back(0);
+            queues.emplace_back();
+        }
+
+        EventHandler::~EventHandler() {
+            for (EventQueue& queue : queues) {
+                clear(queue, queue.pending);
+                clear(queue, queue.dispatching);
+            }
         }
 
         EventId EventHandler::generateEvent() {
             listeners.emplace_back();
+            delegates.emplace_back();
+            subscribers.push_back(0);
+            queues.emplace_back();
             return listeners.size() - 1;
         }
 
         void EventHandler::subscribeEvent(uint32_t eventId, Listener* listener) {
             listeners[eventId].push_back(listener);
+            subscribers[eventId]++;
         }
 
         void EventHandler::unsubscribeEvent(uint32_t eventId, Listener* toRemove) {
             std::vector<Listener*>& v = listeners[eventId];
-            v.erase(std::remove(v.begin(), v.end(), toRemove), v.end());    // Erase–remove idiom
+            auto removed = std::remove(v.begin(), v.end(), toRemove);
+            subscribers[eventId] -= v.end() - removed;
+            v.erase(removed, v.end());    // Erase–remove idiom
+        }
+
+        Subscription EventHandler::subscribeEvent(uint32_t eventId, Delegate delegate) {
+            return add(delegates[eventId], eventId, 0, delegate);
+        }
+
+        Subscription EventHandler::subscribeEvent(uint32_t eventId, uint32 key, Delegate delegate) {
+            if (key == 0)
+                return subscribeEvent(eventId, delegate);
+            if (key >= keySubscribers.size())
+                keySubscribers.resize(key + 1, 0);
+            if (std::find(keyedEventIds.begin(), keyedEventIds.end(), eventId) == keyedEventIds.end())
+                keyedEventIds.push_back(eventId);
+            keySubscribers[key]++;
+            return add(keyedDelegates[keyOf(eventId, key)], eventId, key, delegate);
+        }
+
+        Subscription EventHandler::add(DelegateList& list, EventId eventId, uint32 key, Delegate delegate) {
+            uint32 handle;
+            if (list.freeHandles.empty()) {
+                handle = list.positions.size();
+                list.positions.push_back(0);
+                list.generations.push_back(0);
+            } else {
+                handle = list.freeHandles.back();
+                list.freeHandles.pop_back();
+            }
+
+            if (list.emitting > 0) {
+                list.positions[handle] = list.delegates.size() + list.added.size();
+                list.added.push_back(delegate);
+                list.addedHandles.push_back(handle);
+            } else {
+                list.positions[handle] = list.delegates.size();
+                list.delegates.push_back(delegate);
+                list.handles.push_back(handle);
+            }
+            subscribers[eventId]++;
+            return Subscription{eventId, key, handle, list.generations[handle]};
+        }
+
+        void EventHandler::unsubscribeEvent(Subscription subscription) {
+            if (subscription.eventId == 0 || subscription.eventId >= delegates.size())
+                return;
+            DelegateList* list = &delegates[subscription.eventId];
+            if (subscription.key != 0) {
+                auto found = keyedDelegates.find(keyOf(subscription.eventId, subscription.key));
+                if (found == keyedDelegates.end())
+                    return;
+                list = &found->second;
+            }
+            if (subscription.handle >= list->generations.size()
+                || list->generations[subscription.handle] != subscription.generation)
+                return;
+            remove(*list, subscription.eventId, subscription.key, subscription.handle);
+        }
+
+        void EventHandler::unsubscribeKey(uint32 key) {
+            if (!hasKeySubscriptions(key))
+                return;
+            for (EventId eventId : keyedEventIds) {
+                auto found = keyedDelegates.find(keyOf(eventId, key));
+                if (found == keyedDelegates.end())
+                    continue;
+                DelegateList& list = found->second;
+                // Backwards, so not emitting lists only remove their last delegate
+                for (uint32 position = list.delegates.size() + list.added.size(); position-- > 0;) {
+                    bool added = position >= list.delegates.size();
+                    uint32 i = added ? position - list.delegates.size() : position;
+                    if ((added ? list.added[i] : list.delegates[i]).function != nullptr)
+                        remove(list, eventId, key, added ? list.addedHandles[i] : list.handles[i]);
+                }
+            }
+        }
+
+        void EventHandler::remove(DelegateList& list, EventId eventId, uint32 key, uint32 handle) {
+            list.generations[handle]++;
+            list.freeHandles.push_back(handle);
+            subscribers[eventId]--;
+            if (key != 0)
+                keySubscribers[key]--;
+            uint32 position = list.positions[handle];
+
+            if (list.emitting > 0) {
+                if (position < list.delegates.size())
+                    list.delegates[position].function = nullptr;
+                else
+                    list.added[position - list.delegates.size()].function = nullptr;
+                list.cleared = true;
+                return;
+            }
+
+            list.delegates[position] = list.delegates.back();
+            list.handles[position] = list.handles.back();
+            list.positions[list.handles[position]] = position;
+            list.delegates.pop_back();
+            list.handles.pop_back();
         }
 
-        void EventHandler::emitEvent(uint32_t eventId, const void* event) {
+        void EventHandler::emitToListeners(EventId eventId, const void* event) {
             std::vector<Listener*>& eventListeners = listeners[eventId];
             for (Listener* listener : eventListeners) {
                 listener->receive(eventId, event);
             }
         }
 
+        void EventHandler::emitEvent(uint32_t eventId, uint32 key, const void* event) {
+            emitEvent(eventId, event);
+            if (!hasKeySubscriptions(key))
+                return;
+            auto found = keyedDelegates.find(keyOf(eventId, key));
+            if (found != keyedDelegates.end() && !found->second.delegates.empty())
+                emitToDelegates(found->second, event);
+        }
+
+        void EventHandler::emitToDelegates(DelegateList& list, const void* events, uint32 amount, size_t size) {
+            Emitting emitting(this, list);
+            const Delegate* begin = list.delegates.data();
+            const Delegate* end = begin + list.delegates.size();
+            for (uint32 i = 0; i < amount; i++) {
+                const void* event = static_cast<const char*>(events) + i * size;
+                for (const Delegate* delegate = begin; delegate != end; ++delegate) {
+                    auto function = delegate->function;
+                    if (function != nullptr)
+                        function(delegate->context, event);
+                }
+            }
+        }
+
+        void EventHandler::compact(DelegateList& list) {
+            uint32 kept = 0;
+            for (uint32 i = 0; i < list.delegates.size(); i++)
+                if (list.delegates[i].function != nullptr) {
+                    list.delegates[kept] = list.delegates[i];
+                    list.handles[kept] = list.handles[i];
+                    list.positions[list.handles[kept]] = kept;
+                    kept++;
+                }
+            list.delegates.resize(kept);
+            list.handles.resize(kept);
+
+            for (uint32 i = 0; i < list.added.size(); i++)
+                if (list.added[i].function != nullptr) {
+                    list.positions[list.addedHandles[i]] = list.delegates.size();
+                    list.delegates.push_back(list.added[i]);
+                    list.handles.push_back(list.addedHandles[i]);
+                }
+            list.added.clear();
+            list.addedHandles.clear();
+            list.cleared = false;
+        }
+
+        void* EventHandler::enqueueEvent(uint32_t eventId, size_t size, size_t alignment,
+                                         void(* moveFunc)(void*, void*), void(* destroyFunc)(void*)) {
+            if (alignment > alignof(std::max_align_t))
+                throw std::invalid_argument("Queued events can't be over-aligned");
+
+            EventQueue& queue = queues[eventId];
+            queue.size = size;
+            queue.moveFunc = moveFunc;
+            queue.destroyFunc = destroyFunc;
+
+            EventBuffer& buffer = queue.pending;
+            if (buffer.amount == 0)
+                pendingIds.push_back(eventId);
+
+            if (buffer.amount == buffer.capacity) {     // grow geometrically, moving the events
+                uint32 capacity = std::max<uint32>(16, buffer.capacity * 2);
+                std::unique_ptr<char[]> data(new char[capacity * size]);
+                if (moveFunc != nullptr)
+                    for (uint32 i = 0; i < buffer.amount; i++)
+                        moveFunc(data.get() + i * size, buffer.data.get() + i * size);
+                else if (buffer.amount != 0)
+                    std::memcpy(data.get(), buffer.data.get(), buffer.amount * size);
+                buffer.data = std::move(data);
+                buffer.capacity = capacity;
+            }
+
+            return buffer.data.get() + buffer.amount++ * size;
+        }
+
+        void EventHandler::dispatchQueued() {
+            collectProduced();
+
+            std::vector<EventId> ids;
+            ids.swap(pendingIds);
+            for (EventId eventId : ids)
+                std::swap(queues[eventId].pending, queues[eventId].dispatching);
+
+            try {
+                for (EventId eventId : ids)
+                    dispatch(eventId);
+            } catch (...) {
+                for (EventId eventId : ids)
+                    clear(queues[eventId], queues[eventId].dispatching);
+                throw;
+            }
+        }
+
+        void EventHandler::dispatchQueued(uint32_t eventId) {
+            collectProduced();
+
+            EventQueue& queue = queues[eventId];
+            if (queue.pending.amount == 0 || queue.dispatching.amount != 0)  // nothing or dispatching already
+                return;
+
+            pendingIds.erase(std::remove(pendingIds.begin(), pendingIds.end(), eventId), pendingIds.end());
+            std::swap(queue.pending, queue.dispatching);
+            try {
+                dispatch(eventId);
+            } catch (...) {
+                clear(queue, queue.dispatching);
+                throw;
+            }
+        }
+
+        void EventHandler::reserveProducers(uint32 amount) {
+            while (producers.size() < amount)
+                producers.emplace_back(new EventProducer());
+        }
+
+        void EventHandler::collectProduced() {
+            for (std::unique_ptr<EventProducer>& producer : producers)
+                producer->consume([this](const EventProducer::Header& header, void* event) {
+                    void* queued = enqueueEvent(header.eventId, header.size, 1, header.moveFunc, header.destroyFunc);
+                    if (header.moveFunc == nullptr)
+                        std::memcpy(queued, event, header.size);
+                    else
+                        header.moveFunc(queued, event);     // destroys the moved event
+                });
+        }
+
+        void EventHandler::dispatch(EventId eventId) {
+            if (queues[eventId].dispatching.amount == 0)
+                return;
+            // Listeners may enqueue further events, so the queue is looked up again after each listener
+            for (size_t i = 0; i < listeners[eventId].size(); i++) {
+                EventQueue& queue = queues[eventId];
+                listeners[eventId][i]->receiveAll(eventId, queue.dispatching.data.get(), queue.dispatching.amount,
+                                                  queue.size);
+            }
+            if (!delegates[eventId].delegates.empty()) {
+                EventQueue& queue = queues[eventId];
+                emitToDelegates(delegates[eventId], queue.dispatching.data.get(), queue.dispatching.amount,
+                                queue.size);
+            }
+            clear(queues[eventId], queues[eventId].dispatching);
+        }
+
+        void EventHandler::clear(EventQueue& queue, EventBuffer& buffer) {
+            if (queue.destroyFunc != nullptr)
+                for (uint32 i = 0; i < buffer.amount; i++)
+                    queue.destroyFunc(buffer.data.get() + i * queue.size);
+            buffer.amount = 0;
+        }
+
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2019 Nico Kluge <klugenico@mailbox.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file LICENSE, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Nico Kluge <klugenico@mailbox.org>
+ */
+
+#include <algorithm>
+#include "../JobSystem.h"
+
+namespace sEcs {
+
+    namespace {
+
+        thread_local JobSystem* ownSystem = nullptr;    // the job system the current thread works for
+        thread_local uint32 ownIndex = 0;
+
+    }
+
+
+    JobSystem::JobSystem(uint32 threadAmount) :
+            queuedJobs(0), nextWorker(0), sleeping(0) {
+        if (threadAmount == 0)
+            threadAmount = std::max(1u, std::thread::hardware_concurrency());
+
+        for (uint32 i = 0; i < threadAmount; i++)
+            workers.emplace_back(new Worker());
+        for (uint32 i = 0; i < threadAmount; i++)
+            workers[i]->thread = std::thread(&JobSystem::work, this, i + 1);
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for (auto& worker : workers)
+            worker->thread.join();
+    }
+
+    void JobSystem::submit(std::function<void()> job, JobCounter& counter) {
+        counter.pending++;
+        queuedJobs++;
+
+        uint32 index = getThreadIndex();
+        if (index == 0)
+            index = nextWorker++ % workers.size() + 1;
+
+        Worker& worker = *workers[index - 1];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.jobs.push_back(Job{std::move(job), &counter});
+        }
+
+        if (sleeping > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wakeUp.notify_one();
+        }
+    }
+
+    void JobSystem::wait(JobCounter& counter) {
+        uint32 index = getThreadIndex();
+        while (!counter.isDone()) {
+            if (!runJob(index))
+                std::this_thread::yield();
+        }
+
+        if (counter.exception) {
+            std::exception_ptr exception = counter.exception;
+            counter.exception = nullptr;
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void JobSystem::parallelFor(uint32 amount, uint32 chunkSize,
+                                const std::function<void(uint32 begin, uint32 end)>& func) {
+        if (amount == 0)
+            return;
+
+        chunkSize = std::max(1u, chunkSize);
+        uint32 chunkAmount = (amount - 1) / chunkSize + 1;
+        std::atomic<uint32> nextChunk(0);
+
+        auto process = [&]() {
+            for (uint32 chunk = nextChunk++; chunk < chunkAmount; chunk = nextChunk++) {
+                uint32 begin = chunk * chunkSize;
+                func(begin, std::min(begin + chunkSize, amount));
+            }
+        };
+
+        JobCounter counter;
+        uint32 jobs = std::min<uint32>(workers.size() + 1, chunkAmount);
+        for (uint32 i = 0; i < jobs; i++)
+            submit(process, counter);
+        wait(counter);
+    }
+
+    uint32 JobSystem::getThreadIndex() {
+        return ownSystem == this ? ownIndex : 0;
+    }
+
+    void JobSystem::work(uint32 index) {
+        ownSystem = this;
+        ownIndex = index;
+
+        while (true) {
+            if (runJob(index))
+                continue;
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleeping++;
+            wakeUp.wait(lock, [this]() { return stopping || queuedJobs > 0; });
+            sleeping--;
+            if (stopping && queuedJobs == 0)
+                return;
+        }
+    }
+
+    bool JobSystem::runJob(uint32 index) {
+        Job job;
+        bool found = false;
+
+        if (index != 0) {
+            Worker& own = *workers[index - 1];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                found = true;
+            }
+        }
+
+        for (uint32 i = 0; !found && i < workers.size(); i++) {
+            Worker& victim = *workers[(index + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                found = true;
+            }
+        }
+
+        if (!found)
+            return false;
+
+        queuedJobs--;
+        run(job);
+        return true;
+    }
+
+    void JobSystem::run(Job& job) {
+        try {
+            job.func();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job.counter->mutex);
+            if (!job.counter->exception)
+                job.counter->exception = std::current_exception();
+        }
+
+        job.func = nullptr;     // the counter may be gone right after the last job
+        job.counter->pending--;
+    }
+
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2019 Nico Kluge <klugenico@mailbox.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file LICENSE, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Nico Kluge <klugenico@mailbox.org>
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include "../SlabAllocator.h"
+
+namespace sEcs {
+
+    SlabAllocator::SlabAllocator(size_t typeSize, size_t alignment) {
+        alignment = std::max(alignment, alignof(void*));
+        this->alignment = alignment;
+        blockSize = std::max(typeSize, sizeof(void*));      // free blocks store the next free block
+        blockSize = (blockSize + alignment - 1) / alignment * alignment;
+        blocksPerSlab = std::max<size_t>(1, SLAB_SIZE / blockSize);
+    }
+
+    SlabAllocator::~SlabAllocator() {
+        for (Slab* slab : slabs) {
+            operator delete(slab->memory);
+            delete slab;
+        }
+    }
+
+    void* SlabAllocator::allocate() {
+        if (available.empty()) {
+            auto* slab = new Slab;
+            // operator new only aligns to max_align_t, over-aligned blocks get a slab with some spare bytes
+            size_t spare = alignment > alignof(std::max_align_t) ? alignment - 1 : 0;
+            slab->memory = static_cast<char*>(operator new(blocksPerSlab * blockSize + spare));
+            auto address = reinterpret_cast<std::uintptr_t>(slab->memory);
+            slab->data = slab->memory + ((address + alignment - 1) / alignment * alignment - address);
+            slabs.insert(std::upper_bound(slabs.begin(), slabs.end(), slab,
+                    [](Slab* a, Slab* b) { return a->data < b->data; }), slab);
+            available.push_back(slab);
+        }
+
+        Slab* slab = available.back();
+        void* block;
+        if (slab->freeList != nullptr) {
+            block = slab->freeList;
+            slab->freeList = *reinterpret_cast<void**>(block);
+        } else
+            block = slab->data + slab->untouched++ * blockSize;
+
+        if (++slab->used == blocksPerSlab) {
+            available.pop_back();
+            slab->available = false;
+        }
+
+        usedBlocks++;
+        return block;
+    }
+
+    void SlabAllocator::deallocate(void* block) {
+        Slab* slab = findSlab(block);
+        *reinterpret_cast<void**>(block) = slab->freeList;
+        slab->freeList = block;
+        usedBlocks--;
+
+        if (!slab->available) {
+            slab->available = true;
+            available.push_back(slab);
+        }
+
+        if (--slab->used == 0 && available.size() > 1)
+            release(slab);
+    }
+
+    SlabStats SlabAllocator::getStats() const {
+        SlabStats stats;
+        stats.slabs = slabs.size();
+        stats.usedBlocks = usedBlocks;
+        stats.capacity = slabs.size() * blocksPerSlab;
+        return stats;
+    }
+
+    SlabAllocator::Slab* SlabAllocator::findSlab(void* block) {
+        auto found = std::upper_bound(slabs.begin(), slabs.end(), static_cast<char*>(block),
+                [](char* address, Slab* slab) { return address < slab->data; });
+        return *(found - 1);
+    }
+
+    void SlabAllocator::release(Slab* slab) {
+        available.erase(std::find(available.begin(), available.end(), slab));
+        slabs.erase(std::find(slabs.begin(), slabs.end(), slab));
+        operator delete(slab->memory);
+        delete slab;
+    }
+
+}
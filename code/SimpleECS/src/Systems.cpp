@@ -9,6 +9,7 @@
  */
 
 
+#include <stdexcept>
 #include "../Systems.h"
 
 
@@ -20,7 +21,9 @@ namespace sEcs {
 
         IteratingSystem::IteratingSystem(Core* core, std::vector<ComponentId> componentIds)
                 : _core(core), componentIds(std::move(componentIds)) {
-            setIteratorId = _core->createSetIterator(componentIds);
+            setIteratorId = _core->createSetIterator(this->componentIds);
+            for (ComponentId componentId : this->componentIds)
+                declareWrite(componentId);
         }
 
 
@@ -31,10 +34,15 @@ namespace sEcs {
 
         void IterateAllSystem::update(DELTA_TYPE delta) {
             start(delta);
-            sEcs::EntityId entityId = _core->nextEntity(setIteratorId);
-            while (entityId.index != sEcs::INVALID) {
-                update(entityId, delta);
-                entityId = _core->nextEntity(setIteratorId);
+            try {
+                sEcs::EntityId entityId = _core->nextEntity(setIteratorId);
+                while (entityId.index != sEcs::INVALID) {
+                    update(entityId, delta);
+                    entityId = _core->nextEntity(setIteratorId);
+                }
+            } catch (...) {
+                _core->resetSetIterator(setIteratorId);
+                throw;
             }
             end(delta);
         }
@@ -60,26 +68,34 @@ namespace sEcs {
                 start(delta);
 
             sEcs::EntityId entityId;
-            if (leftIntervals == 1) {
-                entityId = _core->nextEntity(setIteratorId);
-
-                while (entityId.index != sEcs::INVALID) {
-                    update(entityId, overallDelta);
+            try {
+                if (leftIntervals == 1) {
                     entityId = _core->nextEntity(setIteratorId);
-                }
-            } else {
-                sEcs::uint32 amount =
-                        (_core->getEntityAmount(setIteratorId) - treated) /
-                        leftIntervals;
 
-                for (sEcs::uint32 i = 0; i < amount; i++) {
-                    entityId = _core->nextEntity(setIteratorId);
-                    if (entityId.index == sEcs::INVALID)
-                        break;
-                    update(entityId, overallDelta);
+                    while (entityId.index != sEcs::INVALID) {
+                        update(entityId, overallDelta);
+                        entityId = _core->nextEntity(setIteratorId);
+                    }
+                } else {
+                    sEcs::uint32 amount =
+                            (_core->getEntityAmount(setIteratorId) - treated) /
+                            leftIntervals;
+
+                    for (sEcs::uint32 i = 0; i < amount; i++) {
+                        entityId = _core->nextEntity(setIteratorId);
+                        if (entityId.index == sEcs::INVALID)
+                            break;
+                        update(entityId, overallDelta);
+                    }
+
+                    treated += amount;
                 }
-
-                treated += amount;
+            } catch (...) {     // the iteration spans the intervals, so the next update begins it again
+                _core->resetSetIterator(setIteratorId);
+                treated = 0;
+                leftIntervals = intervals;
+                deltaSum = 0;
+                throw;
             }
 
             deltaSum += delta;
@@ -254,11 +254,13 @@ private:
                     if (left.entity == right.entity) continue;
                     if (collided(left, right)) {
                         CollisionEvent collisionEvent = CollisionEvent(left.entity, right.entity);
-                        emitEvent(collisionEvent);
+                        enqueueEvent(collisionEvent);
                     }
                 }
             }
         }
+        // All collisions of the frame at once, before the ExplosionSystem gets updated
+        dispatchQueued<CollisionEvent>();
     }
 
     float length(const sf::Vector2f &v) {
@@ -280,11 +282,18 @@ public:
         auto* particle = entity.getComponent<Particle>();
         particle->alpha -= particle->d * delta;
         if (particle->alpha <= 0) {
-            entity.erase();
+            commands.eraseEntity(entity);
         } else {
             particle->colour.a = particle->alpha;
         }
     }
+
+    void end(sEcs::DELTA_TYPE) override {
+        commands.playback();
+    }
+
+private:
+    sEcs::CommandBuffer commands;
 };
 
 
@@ -366,6 +375,12 @@ public:
         }
     }
 
+    void receiveAll(const CollisionEvent* collisionEvents, sEcs::uint32 amount) override {
+        collided.reserve(collided.size() + 2 * amount);
+        for (sEcs::uint32 i = 0; i < amount; i++)
+            receive(collisionEvents[i]);
+    }
+
     void receive(const CollisionEvent& collisionEvent) override {
         // Events are immutable, so we can't destroy the entities here. We defer
         // the work until the update loop.
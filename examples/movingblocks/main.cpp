@@ -408,19 +408,15 @@ public:
 };
 
 
-class MoveSystem : public sEcs::IntervalSystem<Movement, Position> {
-
-public:
-    MoveSystem(sEcs::uint32 intervals) : IntervalSystem(intervals) {}
+class MoveSystem : public sEcs::System {
 
 private:
+    sEcs::View<Movement, Position> moving = sEcs::view<Movement, Position>();
 
-    void update(sEcs::Entity entity, float delta) override {
-
-        auto* position = entity.getComponent<Position>();
-        auto* movement = entity.getComponent<Movement>();
-
-        position->move(movement->x() * delta, movement->y() * delta);
+    void update(float delta) override {
+        moving.each([delta](Movement& movement, Position& position) {
+            position.move(movement.x() * delta, movement.y() * delta);
+        });
     }
 };
 
@@ -604,7 +600,7 @@ void initEcs() {
 
     sEcs::addSystem(std::make_shared<PlayerSystem>(player));
     sEcs::addSystem(std::make_shared<PerceptionSystem>(10));
-    sEcs::addSystem(std::make_shared<MoveSystem>(1));
+    sEcs::addSystem(std::make_shared<MoveSystem>());
     sEcs::addSystem(std::make_shared<CollisionSystem>(1));
     sEcs::addSystem(std::make_shared<KISystem>(8));
 
@@ -1,6 +1,7 @@
 #define MAX_ENTITY_AMOUNT 10000000
 #define MAX_COMPONENT_AMOUNT 31
 
+#include <cmath>
 #include <SimpleECS/TypeWrapper.h>
 #include "Timer.h"
 #include "gtest/gtest.h"
@@ -60,6 +61,14 @@ struct C9 {
 struct C10 {
 };
 
+struct Velocity {
+    float x = 0, y = 0;
+};
+
+struct Mass {
+    float mass = 1;
+};
+
 class BenchmarkFixture : public ::testing::Test {
 protected:
     BenchmarkFixture() : manager() {
@@ -81,6 +90,40 @@ TEST_F(BenchmarkFixture, TestCreateEntities) {
 }
 
 
+TEST_F(BenchmarkFixture, TestCreateEntitiesAtOnce) {
+    sEcs::uint32 count = 1000000;
+
+    cout << "creating " << count << " entities with two valued components, one by one and at once" << endl;
+
+    double oneByOne;
+    {
+        EcsManager loopManager;
+        sEcs::initTypeManaging(loopManager);
+        sEcs::registerComponent<Velocity>();
+        sEcs::registerComponent<Mass>();
+        sEcs::createSetIterator<Velocity, Mass>();
+
+        Timer timer;
+        for (sEcs::uint32 i = 0; i < count; i++)
+            sEcs::createEntity().addComponents(Velocity(), Mass());
+        oneByOne = timer.elapsed();
+        cout << oneByOne << " seconds one by one" << endl;
+    }
+
+    sEcs::initTypeManaging(manager);
+    sEcs::registerComponent<Velocity>();
+    sEcs::registerComponent<Mass>();
+    SetIteratorId moving = sEcs::createSetIterator<Velocity, Mass>();
+
+    Timer timer;
+    auto entities = sEcs::createEntities(count, Velocity(), Mass());
+    double atOnce = timer.elapsed();
+    cout << atOnce << " seconds at once, " << oneByOne / atOnce << " times faster" << endl;
+
+    ASSERT_EQ(entities.size(), count);
+    ASSERT_EQ(manager.getEntityAmount(moving), count);
+}
+
 TEST_F(BenchmarkFixture, TestDestroyEntities) {
     sEcs::initTypeManaging(manager);
     vector<sEcs::Entity> entities;
@@ -96,6 +139,78 @@ TEST_F(BenchmarkFixture, TestDestroyEntities) {
   }
 }
 
+TEST_F(BenchmarkFixture, TestDestroyEntitiesAtOnce) {
+    sEcs::initTypeManaging(manager);
+    vector<sEcs::Entity> entities = sEcs::createEntities(MAX_ENTITY_AMOUNT);
+
+    AutoTimer t;
+    cout << "destroying " << MAX_ENTITY_AMOUNT << " entities at once" << endl;
+
+    sEcs::eraseEntities(entities);
+}
+
+TEST_F(BenchmarkFixture, TestDestroyEntitiesWithComponents) {
+    sEcs::initTypeManaging(manager);
+    sEcs::uint32 count = 1000000;
+    sEcs::registerComponent<Velocity>();
+    sEcs::registerComponent<Mass>();
+    SetIteratorId moving = sEcs::createSetIterator<Velocity, Mass>();
+
+    cout << "destroying " << count << " entities with two valued components one by one, at once and as query" << endl;
+
+    vector<sEcs::Entity> entities = sEcs::createEntities(count, Velocity(), Mass());
+    Timer timer;
+    for (auto e : entities)
+        sEcs::eraseEntity(e);
+    cout << timer.elapsed() << " seconds one by one" << endl;
+
+    entities = sEcs::createEntities(count, Velocity(), Mass());
+    timer.restart();
+    sEcs::eraseEntities(entities);
+    cout << timer.elapsed() << " seconds at once" << endl;
+
+    sEcs::createEntities(count, Velocity(), Mass());
+    timer.restart();
+    sEcs::eraseAll<Velocity, Mass>();
+    cout << timer.elapsed() << " seconds as query" << endl;
+
+    ASSERT_EQ(manager.getEntityAmount(moving), 0);
+}
+
+TEST_F(BenchmarkFixture, TestStructuralChangesWithoutListeners) {
+    sEcs::initTypeManaging(manager);
+    sEcs::uint32 count = 1000000;
+    sEcs::registerComponent<Velocity>();
+    sEcs::registerComponent<Mass>();
+
+    cout << "creating, changing and erasing " << count << " entities one by one, events enabled without listeners"
+         << endl;
+
+    vector<sEcs::Entity> entities;
+    entities.reserve(count);
+    Timer timer;
+    for (sEcs::uint32 i = 0; i < count; i++)
+        entities.push_back(sEcs::createEntity());
+    cout << timer.elapsed() << " seconds creating" << endl;
+
+    timer.restart();
+    for (sEcs::Entity& entity : entities)
+        entity.addComponent(Velocity());
+    for (sEcs::Entity& entity : entities)
+        entity.addComponents(Mass());
+    cout << timer.elapsed() << " seconds adding" << endl;
+
+    timer.restart();
+    for (sEcs::Entity& entity : entities)
+        entity.deleteComponent<Mass>();
+    cout << timer.elapsed() << " seconds deleting" << endl;
+
+    timer.restart();
+    for (sEcs::Entity& entity : entities)
+        entity.erase();
+    cout << timer.elapsed() << " seconds erasing" << endl;
+}
+
 /*
 TEST_F(BenchmarkFixture, TestCreateEntitiesWithListener) {
   Listener listen;
@@ -218,3 +333,335 @@ TEST_F(BenchmarkFixture, TestEntityIterationUnpackTen) {
         e.getComponent<C10>();
     }
 }
+
+TEST_F(BenchmarkFixture, TestEntityIterationUnpackTwoValued) {
+    sEcs::initTypeManaging(manager);
+    int count = MAX_ENTITY_AMOUNT;
+    sEcs::registerComponent<Velocity>();
+    sEcs::registerComponent<Mass>();
+    vector<sEcs::Entity> entities;
+
+    for (int i = 0; i < count; i++) {
+        auto e = sEcs::createEntity();
+        e.addComponents(Velocity(), Mass());
+        entities.push_back(e);
+    }
+
+    AutoTimer t;
+    cout << "iterating over " << count << " entities, unpacking two valued components" << endl;
+
+    for (auto e : entities) {
+        e.getComponent<Velocity>()->x += e.getComponent<Mass>()->mass;
+    }
+}
+
+TEST_F(BenchmarkFixture, TestBitsetContains) {
+    Core_Intern::BitSet<1024> entityMask;
+    Core_Intern::BitSet<1024> setMask;
+    for (uint32 bit = 0; bit < 1024; bit += 3)
+        entityMask.set(bit);
+    setMask.set(999);
+    setMask.set(3);
+
+    int count = MAX_ENTITY_AMOUNT;
+    uint32 matches = 0;
+
+    AutoTimer t;
+    cout << count << " times contains of 1024 bit masks" << endl;
+
+    for (int i = 0; i < count; i++) {
+        matches += entityMask.contains(&setMask);
+        entityMask.set(i % 1024);
+    }
+    ASSERT_EQ(matches, count);
+}
+
+TEST_F(BenchmarkFixture, TestMembershipUpdatesByComponentAmount) {
+    uint32 count = 100000;
+
+    for (uint32 componentAmount : {2u, 8u, MAX_COMPONENT_AMOUNT - 1u}) {
+        Core core(count);
+        vector<ComponentId> componentIds;
+        for (uint32 i = 0; i < componentAmount; i++) {
+            componentIds.push_back(core.registerTagComponent());
+            core.createSetIterator({componentIds.back()});
+        }
+        vector<EntityId> entities;
+        for (uint32 i = 0; i < count; i++)
+            entities.push_back(core.createEntity());
+
+        AutoTimer t;
+        cout << "adding and deleting " << componentAmount << " components with one set each on "
+             << count << " entities" << endl;
+
+        for (EntityId entityId : entities) {
+            core.activateComponents(entityId, &componentIds.front(), componentAmount);
+            for (ComponentId componentId : componentIds)
+                core.deleteComponent(entityId, componentId);
+        }
+    }
+}
+
+TEST_F(BenchmarkFixture, TestViewIterationTwoValued) {
+    sEcs::initTypeManaging(manager);
+    int count = MAX_ENTITY_AMOUNT;
+    sEcs::registerComponent<Velocity>();
+    sEcs::registerComponent<Mass>();
+
+    for (int i = 0; i < count; i++)
+        sEcs::createEntity().addComponents(Velocity(), Mass());
+
+    auto moving = sEcs::view<Velocity, Mass>();
+
+    AutoTimer t;
+    cout << "iterating over " << count << " entities with a view of two valued components" << endl;
+
+    moving.each([](Velocity& velocity, Mass& mass) {
+        velocity.x += mass.mass;
+    });
+}
+
+TEST_F(BenchmarkFixture, TestParallelViewIteration) {
+    sEcs::initTypeManaging(manager);
+    int count = 1000000;
+    sEcs::registerComponent<Velocity>();
+    sEcs::registerComponent<Mass>();
+
+    for (int i = 0; i < count; i++)
+        sEcs::createEntity().addComponents(Velocity(), Mass());
+
+    auto moving = sEcs::view<Velocity, Mass>();
+    auto work = [](Velocity& velocity, Mass& mass) {
+        for (int i = 0; i < 100; i++)
+            velocity.x = std::sqrt(velocity.x + mass.mass);
+    };
+
+    cout << "iterating over " << count << " entities with heavy work, sequential and on "
+         << manager.getJobSystem().getThreadAmount() << " threads" << endl;
+
+    Timer timer;
+    moving.each(work);
+    double sequential = timer.elapsed();
+    cout << sequential << " seconds sequential" << endl;
+
+    timer.restart();
+    moving.eachParallel(work);
+    double parallel = timer.elapsed();
+    cout << parallel << " seconds parallel, speedup " << sequential / parallel << endl;
+}
+
+TEST_F(BenchmarkFixture, TestJobDispatch) {
+    JobSystem& jobSystem = manager.getJobSystem();
+    const int count = 1000000;
+    std::atomic<int> executed(0);
+
+    cout << "dispatching " << count << " empty jobs to " << jobSystem.getThreadAmount() << " workers" << endl;
+
+    JobCounter counter;
+    Timer timer;
+    for (int i = 0; i < count; i++)
+        jobSystem.submit([&executed]() { executed++; }, counter);
+    jobSystem.wait(counter);
+    cout << timer.elapsed() * 1e9 / count << " ns per job submitted by another thread" << endl;
+
+    timer.restart();
+    jobSystem.submit([&]() {
+        for (int i = 0; i < count; i++)
+            jobSystem.submit([&executed]() { executed++; }, counter);
+    }, counter);
+    jobSystem.wait(counter);
+    cout << timer.elapsed() * 1e9 / count << " ns per job submitted by a worker" << endl;
+
+    ASSERT_EQ(executed, 2 * count);
+}
+
+struct ContactEvent {
+    sEcs::EntityId left;
+    sEcs::EntityId right;
+};
+
+class ContactCounter : public Events::Listener {
+public:
+    sEcs::uint32 received = 0;
+
+    void receive(EventId, const void*) override {
+        received++;
+    }
+
+    void receiveAll(EventId, const void*, sEcs::uint32 amount, size_t) override {
+        received += amount;
+    }
+};
+
+TEST_F(BenchmarkFixture, TestProducerThroughput) {
+    const sEcs::uint32 threads = std::max(2u, std::thread::hardware_concurrency());
+    const sEcs::uint32 perThread = 1000000;
+    EventId eventId = manager.generateEvent("ContactEvent");
+    ContactCounter counter;
+    manager.subscribeEvent(eventId, &counter);
+    manager.reserveProducers(threads);
+
+    cout << "enqueueing " << perThread << " events on each of " << threads
+         << " threads, with own producers and with a shared locked queue" << endl;
+
+    Timer timer;
+    vector<std::thread> producers;
+    for (sEcs::uint32 p = 0; p < threads; p++)
+        producers.emplace_back([&, p]() {
+            Events::EventProducer& producer = manager.getProducer(p);
+            for (sEcs::uint32 i = 0; i < perThread; i++) {
+                new (producer.enqueueEvent(eventId, sizeof(ContactEvent), alignof(ContactEvent), nullptr, nullptr))
+                        ContactEvent{sEcs::EntityId(1, i), sEcs::EntityId(1, p)};
+                producer.publish();
+            }
+        });
+    for (std::thread& thread : producers)
+        thread.join();
+    double produced = timer.elapsed();
+    manager.dispatchQueued();
+    double dispatched = timer.elapsed();
+    cout << threads * perThread / produced / 1e6 << " million events per second with producers, "
+         << dispatched - produced << " seconds to collect and dispatch" << endl;
+
+    std::mutex mutex;
+    producers.clear();
+    timer.restart();
+    for (sEcs::uint32 p = 0; p < threads; p++)
+        producers.emplace_back([&, p]() {
+            for (sEcs::uint32 i = 0; i < perThread; i++) {
+                std::lock_guard<std::mutex> lock(mutex);
+                new (manager.enqueueEvent(eventId, sizeof(ContactEvent), alignof(ContactEvent), nullptr, nullptr))
+                        ContactEvent{sEcs::EntityId(1, i), sEcs::EntityId(1, p)};
+            }
+        });
+    for (std::thread& thread : producers)
+        thread.join();
+    cout << threads * perThread / timer.elapsed() / 1e6 << " million events per second with a locked queue" << endl;
+    manager.dispatchQueued();
+
+    ASSERT_EQ(counter.received, 2 * threads * perThread);
+}
+
+struct HitEvent {
+    int damage;
+};
+
+class HitListener : public sEcs::Listener<HitEvent> {
+public:
+    int damage = 0;
+
+    void receive(const HitEvent& event) override {
+        damage += event.damage;
+    }
+
+    void onHit(const HitEvent& event) {
+        damage += event.damage;
+    }
+};
+
+TEST_F(BenchmarkFixture, TestEventDelegates) {
+    sEcs::initTypeManaging(manager);
+    const int count = 1000000;
+    const int listenerAmount = 8;
+    vector<HitListener> listeners(listenerAmount);
+
+    cout << "emitting " << count << " events to " << listenerAmount << " listeners and to as many delegates" << endl;
+
+    // the fastest of some rounds, so a busy machine doesn't decide the comparison
+    const int rounds = 5;
+    double virtualCalls = 0;
+    double delegates = 0;
+    Timer timer;
+    for (int round = 0; round < rounds; round++) {
+        for (HitListener& listener : listeners)
+            sEcs::subscribeEvent<HitEvent>(&listener);
+        timer.restart();
+        for (int i = 0; i < count; i++)
+            sEcs::emitEvent(HitEvent{1});
+        double elapsed = timer.elapsed();
+        virtualCalls = round == 0 ? elapsed : std::min(virtualCalls, elapsed);
+
+        vector<Subscription> subscriptions;
+        for (HitListener& listener : listeners) {
+            sEcs::unsubscribeEvent<HitEvent>(&listener);
+            subscriptions.push_back(sEcs::subscribeEvent<HitEvent, HitListener, &HitListener::onHit>(&listener));
+        }
+        timer.restart();
+        for (int i = 0; i < count; i++)
+            sEcs::emitEvent(HitEvent{1});
+        elapsed = timer.elapsed();
+        delegates = round == 0 ? elapsed : std::min(delegates, elapsed);
+        for (Subscription subscription : subscriptions)
+            sEcs::unsubscribeEvent(subscription);
+    }
+    cout << virtualCalls << " seconds with listeners" << endl;
+    cout << delegates << " seconds with delegates, " << virtualCalls / delegates << " times faster" << endl;
+
+    for (HitListener& listener : listeners)
+        ASSERT_EQ(listener.damage, 2 * rounds * count);
+    ASSERT_GT(virtualCalls / delegates, 1.0);
+}
+
+struct Shield {
+    int strength;
+};
+
+class ShieldWidget {
+public:
+    sEcs::EntityId watched;
+    int updates = 0;
+
+    void onAdded(const sEcs::ComponentAddedEvent<Shield>& event) {
+        if (event.entityId == watched)
+            updates++;
+    }
+
+    void onWatchedAdded(const sEcs::ComponentAddedEvent<Shield>&) {
+        updates++;
+    }
+};
+
+TEST_F(BenchmarkFixture, TestEntityFilteredEvents) {
+    sEcs::initTypeManaging(manager);
+    sEcs::registerComponent<Shield>();
+    const int count = 100000;
+    const int widgetAmount = 100;
+
+    cout << "adding a component to " << count << " entities, " << widgetAmount << " widgets watch one entity each"
+         << endl;
+
+    vector<sEcs::Entity> entities;
+    entities.reserve(count);
+    for (int i = 0; i < count; i++)
+        entities.push_back(sEcs::createEntity());
+    vector<ShieldWidget> widgets(widgetAmount);
+    vector<Subscription> subscriptions;
+    for (int i = 0; i < widgetAmount; i++) {
+        widgets[i].watched = entities[i * (count / widgetAmount)].id();
+        subscriptions.push_back(sEcs::subscribeEvent<sEcs::ComponentAddedEvent<Shield>, ShieldWidget,
+                &ShieldWidget::onAdded>(&widgets[i]));
+    }
+
+    Timer timer;
+    for (sEcs::Entity& entity : entities)
+        entity.addComponent(Shield{1});
+    double filtering = timer.elapsed();
+    cout << filtering << " seconds with widgets filtering themselves" << endl;
+
+    for (int i = 0; i < widgetAmount; i++) {
+        sEcs::unsubscribeEvent(subscriptions[i]);
+        sEcs::subscribeEvent<sEcs::ComponentAddedEvent<Shield>, ShieldWidget, &ShieldWidget::onWatchedAdded>(
+                &widgets[i], entities[i * (count / widgetAmount)]);
+    }
+    for (sEcs::Entity& entity : entities)
+        entity.deleteComponent<Shield>();
+
+    timer.restart();
+    for (sEcs::Entity& entity : entities)
+        entity.addComponent(Shield{2});
+    double filtered = timer.elapsed();
+    cout << filtered << " seconds with subscriptions per entity, " << filtering / filtered << " times faster" << endl;
+
+    for (ShieldWidget& widget : widgets)
+        ASSERT_EQ(widget.updates, 2);
+}
@@ -0,0 +1,184 @@
+using std::cout;
+using std::endl;
+using std::vector;
+
+using namespace sEcs;
+
+struct ChunkedName {
+    explicit ChunkedName(std::string name) : name(std::move(name)) {}
+    std::string name;
+};
+
+struct ChunkedValue {
+    explicit ChunkedValue(int value) : value(value) {}
+    int value;
+};
+
+struct ChunkedMark {
+    int pass;
+};
+
+struct alignas(2 * alignof(std::max_align_t)) ChunkedOverAligned {
+    char value;
+};
+
+
+TEST (ArchetypeTest, TestArchetypeStorage) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Register archetype components" << endl;
+
+    registerComponent<ChunkedName>(Storing::ARCHETYPE);
+    registerComponent<ChunkedValue>(Storing::ARCHETYPE);
+
+    SetIteratorId bothIterator = createSetIterator<ChunkedName, ChunkedValue>();
+    SetIteratorId valueIterator = createSetIterator<ChunkedValue>();
+
+    vector<Entity> entities;
+    for (int i = 0; i < 3000; i++) {
+        Entity entity = createEntity();
+        entity.addComponent(ChunkedValue(i));
+        if (i % 2 == 0)
+            entity.addComponent(ChunkedName("Entity with a name too long for small string optimization " + std::to_string(i)));
+        entities.push_back(entity);
+    }
+
+    ASSERT_EQ(manager.getEntityAmount(bothIterator), 1500);
+    ASSERT_EQ(manager.getEntityAmount(valueIterator), 3000);
+
+    for (int i = 0; i < 3000; i += 3)
+        entities[i].deleteComponent<ChunkedValue>();
+    for (int i = 1; i < 3000; i += 4)
+        entities[i].erase();
+
+    for (int i = 0; i < 3000; i++) {
+        if (i % 4 == 1) {
+            ASSERT_FALSE(entities[i].isValid());
+            continue;
+        }
+        auto* value = entities[i].getComponent<ChunkedValue>();
+        auto* name = entities[i].getComponent<ChunkedName>();
+        if (i % 3 == 0)
+            ASSERT_TRUE(value == nullptr);
+        else
+            ASSERT_EQ(value->value, i);
+        if (i % 2 == 0)
+            ASSERT_EQ(name->name, "Entity with a name too long for small string optimization " + std::to_string(i));
+        else
+            ASSERT_TRUE(name == nullptr);
+    }
+
+    // erasing the current entity while iterating must not skip any other entity
+    uint32 visited = 0;
+    for (EntityId entityId = manager.nextEntity(valueIterator); entityId.index != INVALID;
+            entityId = manager.nextEntity(valueIterator)) {
+        visited++;
+        if (visited % 2 == 0)
+            manager.eraseEntity(entityId);
+    }
+    ASSERT_EQ(visited, 1500);
+    ASSERT_EQ(manager.getEntityAmount(valueIterator), 750);
+
+    uint32 amount = 0;
+    while (manager.nextEntity(bothIterator).index != INVALID)
+        amount++;
+    ASSERT_EQ(amount, manager.getEntityAmount(bothIterator));
+
+    // chunks are only aligned for fundamental types
+    ASSERT_THROW(registerComponent<ChunkedOverAligned>(Storing::ARCHETYPE), std::invalid_argument);
+
+}
+
+
+TEST (ArchetypeTest, TestMovingWhileIterating) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Entities change their archetypes while iterating" << endl;
+
+    registerComponent<ChunkedValue>(Storing::ARCHETYPE);
+    registerComponent<ChunkedMark>(Storing::ARCHETYPE);
+
+    SetIteratorId valueIterator = createSetIterator<ChunkedValue>();
+
+    vector<Entity> entities;
+    for (int i = 0; i < 1000; i++) {
+        Entity entity = createEntity();
+        entity.addComponent(ChunkedValue(i));
+        entities.push_back(entity);
+    }
+
+    // Every visited entity moves into the archetype with marks, which gets visited later. Every fourth one also
+    // erases an entity, which is moved into its row, and the last visited entity loses its value.
+    vector<int> visits(1000, 0);
+    vector<bool> erased(1000, false);
+    for (EntityId entityId = manager.nextEntity(valueIterator); entityId.index != INVALID;
+            entityId = manager.nextEntity(valueIterator)) {
+        Entity entity(entityId);
+        int value = entity.getComponent<ChunkedValue>()->value;
+        visits[value]++;
+        entity.addComponent(ChunkedMark{1});
+        if (value % 4 == 0 && value + 1 < 1000 && !erased[value + 1]) {
+            entities[value + 1].erase();
+            erased[value + 1] = true;
+        }
+        if (value % 8 == 2 && value + 3 < 1000) {
+            entities[value + 3].deleteComponent<ChunkedValue>();
+            erased[value + 3] = true;
+        }
+    }
+
+    for (int i = 0; i < 1000; i++)
+        ASSERT_EQ(visits[i], erased[i] ? 0 : 1) << "entity " << i;
+
+    // a new pass visits every entity once
+    uint32 amount = 0;
+    while (manager.nextEntity(valueIterator).index != INVALID)
+        amount++;
+    ASSERT_EQ(amount, manager.getEntityAmount(valueIterator));
+}
+
+TEST (ArchetypeTest, TestInterleavedIterations) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Walk archetypes with several iterators" << endl;
+
+    registerComponent<ChunkedValue>(Storing::ARCHETYPE);
+    registerComponent<ChunkedMark>(Storing::ARCHETYPE);
+
+    SetIteratorId stopped = createSetIterator<ChunkedValue>();
+    SetIteratorId walking = createSetIterator<ChunkedValue>();
+    SetIteratorId moving = createSetIterator<ChunkedValue>();
+
+    for (int i = 0; i < 1000; i++)
+        createEntity().addComponent(ChunkedValue(i));
+
+    // a stopped iteration doesn't notice the entities moving meanwhile
+    for (int i = 0; i < 100; i++)
+        ASSERT_NE(manager.nextEntity(stopped).index, INVALID);
+    manager.resetSetIterator(stopped);
+
+    // the walking iterator continues with the remaining entities, when the moving one moves them
+    vector<int> visits(1000, 0);
+    for (int i = 0; i < 300; i++)
+        visits[Entity(manager.nextEntity(walking)).getComponent<ChunkedValue>()->value]++;
+    for (EntityId entityId = manager.nextEntity(moving); entityId.index != INVALID;
+            entityId = manager.nextEntity(moving))
+        Entity(entityId).addComponent(ChunkedMark{1});
+    for (EntityId entityId = manager.nextEntity(walking); entityId.index != INVALID;
+            entityId = manager.nextEntity(walking))
+        visits[Entity(entityId).getComponent<ChunkedValue>()->value]++;
+
+    for (int i = 0; i < 1000; i++)
+        ASSERT_EQ(visits[i], 1) << "entity " << i;
+
+    uint32 amount = 0;
+    while (manager.nextEntity(stopped).index != INVALID)
+        amount++;
+    ASSERT_EQ(amount, 1000);
+}
@@ -66,4 +66,35 @@ TEST (BitsetTest, TestBitsetContains) {
 
     ASSERT_FALSE(bitsetOne.contains(&bitsetTwo));
 
-}
\ No newline at end of file
+}
+
+TEST (BitsetTest, TestWideBitset) {
+
+    BitSet<1024> bitsetOne = BitSet<1024>();
+    BitSet<1024> bitsetTwo = BitSet<1024>();
+
+    cout << "Bitset with 1024 bits" << endl;
+
+    std::vector<uint32> v = {0, 63, 64, 127, 128, 511, 512, 1000, 1023, 1024};
+    bitsetOne.set(&v);
+
+    for (uint32 bit : v)
+        ASSERT_TRUE(bitsetOne.isSet(bit));
+    ASSERT_FALSE(bitsetOne.isSet(62));
+    ASSERT_FALSE(bitsetOne.isSet(65));
+    ASSERT_FALSE(bitsetOne.isSet(1022));
+
+    bitsetTwo.set(1023);
+    bitsetTwo.set(63);
+    ASSERT_TRUE(bitsetOne.contains(&bitsetTwo));
+
+    bitsetOne.unset(63);
+    ASSERT_FALSE(bitsetOne.isSet(63));
+    ASSERT_TRUE(bitsetOne.isSet(64));
+    ASSERT_FALSE(bitsetOne.contains(&bitsetTwo));
+
+    bitsetTwo.reset();
+    bitsetTwo.set(1024);
+    ASSERT_TRUE(bitsetOne.contains(&bitsetTwo));
+
+}
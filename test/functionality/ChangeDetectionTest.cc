@@ -0,0 +1,217 @@
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+using namespace sEcs;
+
+struct Tracked {
+    int value = 0;
+};
+
+struct Untracked {
+    int value = 0;
+};
+
+
+TEST (ChangeDetectionTest, TestAddedAndChanged) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Added and changed components" << endl;
+
+    registerComponent<Tracked>();
+    registerComponent<Untracked>();
+
+    vector<Entity> entities = createEntities(10, Tracked());
+
+    auto added = view<Added<Tracked>>();
+    auto changed = view<Changed<Tracked>, const Tracked>();
+    auto count = [](View<Added<Tracked>>& view) {
+        int amount = 0;
+        view.each([&]() { amount++; });
+        return amount;
+    };
+    auto countChanged = [&]() {
+        int amount = 0;
+        changed.each([&](const Tracked& tracked) { amount++; });
+        return amount;
+    };
+
+    // the first pass counts all existing components
+    ASSERT_EQ(count(added), 10);
+    ASSERT_EQ(count(added), 0);
+    ASSERT_EQ(countChanged(), 10);
+    ASSERT_EQ(countChanged(), 0);
+
+    Entity first = createEntity();
+    first.addComponent(Tracked());
+    createEntity().addComponents(Tracked(), Untracked());
+    ASSERT_EQ(count(added), 2);
+    ASSERT_EQ(countChanged(), 2);
+
+    entities[3].getComponent<Tracked>()->value = 3;
+    entities[4].readComponent<Tracked>();
+    entities[5].markChanged<Tracked>();
+    entities[6].getComponent<Untracked>();
+    ASSERT_EQ(countChanged(), 2);
+    ASSERT_EQ(count(added), 0);
+
+    // overwriting counts as change
+    entities[7].addComponent(Tracked{7});
+    ASSERT_EQ(count(added), 0);
+    ASSERT_EQ(countChanged(), 1);
+
+    // mutable views mark all passed components
+    view<Tracked>().each([](Tracked& tracked) { tracked.value++; });
+    view<const Tracked>().each([](const Tracked& tracked) {});
+    ASSERT_EQ(countChanged(), 12);
+
+    // readding counts as added
+    first.deleteComponent<Tracked>();
+    first.addComponent(Tracked());
+    ASSERT_EQ(count(added), 1);
+
+    // a mutable view doesn't pass its own changes again
+    auto changing = view<Changed<Tracked>, Tracked>();
+    int passed = 0;
+    changing.each([&](Tracked& tracked) { passed++; });
+    ASSERT_EQ(passed, 12);
+    passed = 0;
+    changing.each([&](Tracked& tracked) { passed++; });
+    ASSERT_EQ(passed, 0);
+    entities[2].markChanged<Tracked>();
+    changing.each([&](Tracked& tracked) { passed++; });
+    ASSERT_EQ(passed, 1);
+
+}
+
+
+TEST (ChangeDetectionTest, TestRemoved) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Removed components" << endl;
+
+    registerComponent<Tracked>();
+    registerComponent<Untracked>();
+
+    auto removed = view<Removed<Tracked>>();
+    auto removedWithUntracked = view<Removed<Tracked>, Untracked>();
+    auto count = [&]() {
+        int amount = 0;
+        removed.each([&](EntityId entityId) { amount++; });
+        return amount;
+    };
+
+    vector<Entity> entities = createEntities(10, Tracked());
+    entities[0].addComponent(Untracked());
+
+    entities[0].deleteComponent<Tracked>();
+    entities[1].deleteComponent<Tracked>();
+    entities[2].erase();    // left out
+    entities[3].addComponents(Untracked());
+
+    int withUntracked = 0;
+    removedWithUntracked.each([&](EntityId entityId, Untracked& untracked) {
+        ASSERT_EQ(entityId.index, entities[0].id().index);
+        withUntracked++;
+    });
+    ASSERT_EQ(withUntracked, 1);
+    ASSERT_EQ(count(), 2);
+    ASSERT_EQ(count(), 0);
+
+    eraseEntities({entities[4]});
+    entities[5].deleteComponent<Tracked>();
+    ASSERT_EQ(count(), 1);
+
+    // removals are kept until the update after the next one
+    Core_Intern::ChangeTracking* tracking =
+            manager.getChangeTracking(TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, Tracked>());
+    ASSERT_EQ(tracking->getRemovals().size(), 5);
+    updateEcs(1);
+    ASSERT_EQ(tracking->getRemovals().size(), 5);
+    updateEcs(1);
+    ASSERT_EQ(tracking->getRemovals().size(), 0);
+
+}
+
+
+class ChangedCounter : public sEcs::IterateAllSystem<Changed<Tracked>, const Tracked> {
+
+public:
+    int passed = 0;
+
+    void update(Entity entity, DELTA_TYPE delta) override {
+        passed++;
+    }
+
+};
+
+class SelfChanging : public sEcs::IterateAllSystem<Changed<Tracked>, Tracked> {
+
+public:
+    int passed = 0;
+
+    void update(Entity entity, DELTA_TYPE delta) override {
+        passed++;
+        entity.getComponent<Tracked>();
+    }
+
+};
+
+class ParallelIncrement : public sEcs::ParallelIterateAllSystem<Added<Tracked>, Tracked> {
+
+public:
+    std::atomic<int> passed{0};
+
+    void update(Entity entity, DELTA_TYPE delta) override {
+        passed++;
+        entity.getComponent<Tracked>()->value++;
+    }
+
+};
+
+TEST (ChangeDetectionTest, TestChangeFilteringSystems) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Systems with change filters" << endl;
+
+    registerComponent<Tracked>();
+
+    auto counter = std::make_shared<ChangedCounter>();
+    auto increment = std::make_shared<ParallelIncrement>();
+    auto changing = std::make_shared<SelfChanging>();
+    addSystem(counter);
+    addSystem(increment);
+    addSystem(changing);
+
+    vector<Entity> entities = createEntities(100, Tracked());
+
+    updateEcs(1);
+    ASSERT_EQ(counter->passed, 100);
+    ASSERT_EQ(increment->passed.load(), 100);
+
+    // the counter sees the changes of the increments
+    updateEcs(1);
+    ASSERT_EQ(counter->passed, 200);
+    ASSERT_EQ(increment->passed.load(), 100);
+
+    updateEcs(1);
+    ASSERT_EQ(counter->passed, 200);
+    ASSERT_EQ(changing->passed, 100);   // neither its own changes nor the earlier ones are passed again
+
+    createEntities(5, Tracked());
+    entities[0].getComponent<Tracked>();
+    updateEcs(1);
+    ASSERT_EQ(counter->passed, 206);
+    ASSERT_EQ(increment->passed.load(), 105);
+
+    for (Entity entity : entities)
+        ASSERT_EQ(entity.readComponent<Tracked>()->value, 1);
+
+}
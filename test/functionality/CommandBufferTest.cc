@@ -0,0 +1,195 @@
+using std::cout;
+using std::endl;
+using std::vector;
+
+using namespace sEcs;
+
+std::atomic<int> livingLabels(0);
+
+struct CommandLabel {
+    explicit CommandLabel(std::string text) : text(std::move(text)) { livingLabels++; }
+    CommandLabel(CommandLabel&& other) noexcept : text(std::move(other.text)) { livingLabels++; }
+    CommandLabel(const CommandLabel& other) : text(other.text) { livingLabels++; }
+    ~CommandLabel() { livingLabels--; }
+    std::string text;
+};
+
+struct CommandPosition {
+    int x = 0;
+    int y = 0;
+};
+
+struct CommandChunked {
+    double value = 0;
+};
+
+struct CommandTag {};
+
+std::atomic<int> livingEmpties(0);
+
+struct CommandEmpty {      // empty, but not a tag
+    CommandEmpty() { livingEmpties++; }
+    CommandEmpty(CommandEmpty&&) noexcept { livingEmpties++; }
+    CommandEmpty(const CommandEmpty&) { livingEmpties++; }
+    ~CommandEmpty() { livingEmpties--; }
+};
+
+
+class RecordingListener : public Listener<ComponentAddedEvent<CommandPosition>> {
+
+public:
+    CommandBuffer* buffer = nullptr;
+    bool rejected = false;
+
+    void receive(const ComponentAddedEvent<CommandPosition>& event) override {
+        try {
+            buffer->eraseEntity(getEntity(event.entityId));
+        } catch (std::logic_error&) {
+            rejected = true;
+        }
+    }
+
+};
+
+
+TEST (CommandBufferTest, TestCommandPlayback) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Record and play back structural changes" << endl;
+
+    registerComponent<CommandLabel>();
+    registerComponent<CommandPosition>();
+    registerComponent<CommandChunked>(Storing::ARCHETYPE);
+    registerComponent<CommandTag>();
+
+    SetIteratorId positioned = createSetIterator<CommandPosition, CommandChunked>();
+    SetIteratorId tagged = createSetIterator<CommandTag>();
+
+    vector<Entity> entities;
+    for (int i = 0; i < 100; i++) {
+        entities.push_back(createEntity());
+        entities.back().addComponent(CommandPosition());
+    }
+
+    CommandBuffer buffer;
+    livingLabels = 0;
+
+    Entity created = buffer.createEntity();
+    buffer.addComponent(created, CommandLabel("created with a label too long for small string optimization"));
+    buffer.addComponent(created, CommandTag());
+    ASSERT_FALSE(created.isValid());    // only a placeholder until the playback
+
+    for (int i = 0; i < 100; i++) {
+        CommandPosition position;
+        position.x = i;
+        buffer.addComponent(entities[i], position);
+        buffer.addComponent(entities[i], CommandChunked());
+        if (i % 2 == 0)
+            buffer.deleteComponent<CommandChunked>(entities[i]);     // the last command wins
+        if (i % 10 == 0) {
+            buffer.addComponent(entities[i], CommandLabel("dropped"));
+            buffer.eraseEntity(entities[i]);
+        }
+    }
+    buffer.addComponent(Entity(EntityId(7, 777)), CommandLabel("invalid"));
+    ASSERT_EQ(livingLabels, 12);
+    ASSERT_FALSE(buffer.isEmpty());
+
+    // nothing is applied before the playback
+    ASSERT_EQ(countEntities(), 100);
+    ASSERT_EQ(manager.getEntityAmount(positioned), 0);
+
+    buffer.playback();
+
+    ASSERT_TRUE(buffer.isEmpty());
+    ASSERT_EQ(livingLabels, 1);     // dropped values got destroyed
+    ASSERT_EQ(countEntities(), 91);
+    ASSERT_EQ(manager.getEntityAmount(positioned), 50);
+    ASSERT_EQ(manager.getEntityAmount(tagged), 1);
+
+    Entity label = getEntity(manager.getIdFromIndex(manager.nextEntity(tagged).index));
+    ASSERT_EQ(label.getComponent<CommandLabel>()->text, "created with a label too long for small string optimization");
+    manager.nextEntity(tagged);
+
+    for (int i = 0; i < 100; i++) {
+        if (i % 10 == 0) {
+            ASSERT_FALSE(entities[i].isValid());
+            continue;
+        }
+        ASSERT_EQ(entities[i].getComponent<CommandPosition>()->x, i);
+        ASSERT_EQ(entities[i].getComponent<CommandChunked>() == nullptr, i % 2 == 0);
+    }
+
+    // recorded values are destroyed with the buffer
+    {
+        CommandBuffer unplayed;
+        unplayed.addComponent(entities[1], CommandLabel("never applied"));
+        ASSERT_EQ(livingLabels, 2);
+    }
+    ASSERT_EQ(livingLabels, 1);
+
+    // listeners must not record into a buffer while it is played back
+    RecordingListener listener;
+    listener.buffer = &buffer;
+    subscribeEvent<ComponentAddedEvent<CommandPosition>>(&listener);
+    buffer.addComponent(buffer.createEntity(), CommandPosition());
+    buffer.playback();
+    ASSERT_TRUE(listener.rejected);
+    unsubscribeEvent<ComponentAddedEvent<CommandPosition>>(&listener);
+
+    label.erase();
+    ASSERT_EQ(livingLabels, 0);
+
+    // empty components with a destructor are constructed in their storage
+    registerComponent<CommandEmpty>();
+    buffer.addComponent(entities[1], CommandEmpty());
+    ASSERT_EQ(livingEmpties, 1);
+    buffer.playback();
+    ASSERT_EQ(livingEmpties, 1);
+    entities[1].deleteComponent<CommandEmpty>();
+    ASSERT_EQ(livingEmpties, 0);
+
+}
+
+
+TEST (CommandBufferTest, TestCommandBuffersPerThread) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Command buffers per thread" << endl;
+
+    registerComponent<CommandPosition>();
+    registerComponent<CommandLabel>();
+
+    JobSystem& jobSystem = manager.getJobSystem();
+    vector<std::unique_ptr<CommandBuffer>> buffers;
+    for (uint32 i = 0; i <= jobSystem.getThreadAmount(); i++)
+        buffers.emplace_back(new CommandBuffer());
+
+    jobSystem.parallelFor(1000, 10, [&](uint32 begin, uint32 end) {
+        CommandBuffer& buffer = *buffers[jobSystem.getThreadIndex()];
+        for (uint32 i = begin; i < end; i++) {
+            Entity entity = buffer.createEntity();
+            CommandPosition position;
+            position.x = i;
+            buffer.addComponent(entity, position);
+            buffer.addComponent(entity, CommandLabel(std::to_string(i)));
+        }
+    });
+
+    for (auto& buffer : buffers)
+        buffer->playback();
+
+    ASSERT_EQ(countEntities(), 1000);
+    vector<bool> seen(1000, false);
+    each<CommandPosition, CommandLabel>([&](CommandPosition& position, CommandLabel& label) {
+        ASSERT_EQ(std::to_string(position.x), label.text);
+        seen[position.x] = true;
+    });
+    for (bool wasSeen : seen)
+        ASSERT_TRUE(wasSeen);
+
+}
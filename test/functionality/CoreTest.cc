@@ -28,7 +28,7 @@ TEST (ManagerTest, TestManagerCreate) {
 
     cout << "Create Manager" << endl;
 
-    ComponentHandle* ph = new PointingComponentHandle( sizeof(Position), [](void *p) { delete reinterpret_cast<Position *>(p); });
+    ComponentHandle* ph = new PointingComponentHandle( sizeof(Position), [](void *p) { reinterpret_cast<Position *>(p)->~Position(); });
     ComponentHandle* sh = new ValuedComponentHandle( sizeof(Size), [](void *p) { reinterpret_cast<Size *>(p)->~Size(); });
 
     ComponentId p_Id = core.registerComponent(ph);
@@ -106,6 +106,599 @@ TEST (ManagerTest, TestManagerCreate) {
     }
     ASSERT_EQ(amount, 18);
 
+    // s2 shares the set of s3
+    amount = 0;
+    while (core.nextEntity(s2).index != INVALID) {
+        amount++;
+    }
+    ASSERT_EQ(amount, 18);
+
     ASSERT_EQ(core.getEntityAmount(), 39);
 
 }
+
+
+TEST (ManagerTest, TestSparseSetComponentHandle) {
+
+    Core core;
+
+    cout << "Sparse set component handle" << endl;
+
+    auto* handle = new SparseSetComponentHandle(sizeof(Size), [](void *p) { reinterpret_cast<Size *>(p)->~Size(); },
+            [](void *destination, void *source) { new(destination) Size(*reinterpret_cast<Size *>(source)); });
+    ComponentId s_Id = core.registerComponent(handle);
+
+    std::vector<EntityId> entities;
+    for (int i = 0; i < 10000; i++)
+        entities.push_back(core.createEntity());
+
+    for (int i = 0; i < 10000; i += 100)
+        new(core.addComponent(entities[i], s_Id)) Size(i);
+
+    ASSERT_EQ(handle->getAmount(), 100);
+
+    for (int i = 0; i < 10000; i += 200)
+        core.deleteComponent(entities[i], s_Id);
+    core.eraseEntity(entities[100]);
+
+    ASSERT_EQ(handle->getAmount(), 49);
+
+    for (int i = 0; i < 10000; i += 100) {
+        auto* size = reinterpret_cast<Size*>(core.getComponent(entities[i], s_Id));
+        if (i % 200 == 0 || i == 100)
+            ASSERT_TRUE(size == nullptr);
+        else
+            ASSERT_EQ(size->size, i);
+    }
+
+    for (uint32 i = 0; i < handle->getAmount(); i++)
+        ASSERT_EQ(reinterpret_cast<Size*>(handle->getDenseComponent(i))->size, handle->getEntityIndex(i) - 1);
+
+}
+
+
+TEST (ManagerTest, TestPointingSlabAllocation) {
+
+    Core core;
+
+    cout << "Pointing component handle slabs" << endl;
+
+    auto* handle = new PointingComponentHandle(sizeof(Position), [](void *p) { reinterpret_cast<Position *>(p)->~Position(); });
+    ComponentId p_Id = core.registerComponent(handle);
+
+    std::vector<EntityId> entities;
+    for (int i = 0; i < 20000; i++) {
+        entities.push_back(core.createEntity());
+        new(core.addComponent(entities.back(), p_Id)) Position();
+    }
+
+    SlabStats stats = handle->getSlabStats();
+    ASSERT_EQ(stats.usedBlocks, 20000);
+    ASSERT_GE(stats.capacity, 20000);
+    ASSERT_GT(stats.slabs, 1);
+
+    for (int i = 0; i < 20000; i++)
+        core.eraseEntity(entities[i]);
+
+    stats = handle->getSlabStats();
+    ASSERT_EQ(stats.usedBlocks, 0);
+    ASSERT_EQ(stats.slabs, 1);      // empty slabs are released, except one
+
+    // blocks keep alignments above the one of operator new
+    const size_t alignment = 16 * alignof(std::max_align_t);
+    ComponentId alignedId = core.registerComponent(new PointingComponentHandle(alignment, nullptr, alignment));
+    for (int i = 0; i < 1000; i++) {
+        void* component = core.addComponent(core.createEntity(), alignedId);
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(component) % alignment, 0);
+    }
+
+}
+
+
+struct Reregistered {
+    int value;
+};
+
+TEST (ManagerTest, TestTypedHandlesPerManager) {
+
+    cout << "Typed handles belong to their manager" << endl;
+
+    {
+        EcsManager first;
+        initTypeManaging(first);
+        registerComponent<Reregistered>();
+        createEntity().addComponent(Reregistered{1});
+    }
+
+    // registered without the typed wrapper, e.g. by a script
+    EcsManager manager;
+    initTypeManaging(manager);
+    manager.registerComponent(TypeWrapper_Intern::className<Reregistered>(),
+                              new ValuedComponentHandle(sizeof(Reregistered), nullptr));
+
+    Entity entity = createEntity();
+    entity.addComponent(Reregistered{2});
+    ASSERT_EQ(entity.getComponent<Reregistered>()->value, 2);
+    ASSERT_EQ(entity.readComponent<Reregistered>()->value, 2);
+}
+
+
+int livingNames = 0;
+
+struct Named {
+    explicit Named(std::string name) : name(std::move(name)) { livingNames++; }
+    Named(const Named& other) : name(other.name) { livingNames++; }
+    ~Named() { livingNames--; }
+    std::string name;
+};
+
+struct alignas(4 * alignof(std::max_align_t)) OverAligned {
+    int value = 0;
+};
+
+TEST (ManagerTest, TestTypedHandleStorage) {
+
+    cout << "Typed handles align and destroy their components" << endl;
+
+    {
+        EcsManager manager;
+        initTypeManaging(manager);
+        registerComponent<Named>();
+        registerComponent<OverAligned>();
+
+        vector<Entity> entities = createEntities(100, Named("a name too long for small string optimization"));
+        entities[3].deleteComponent<Named>();
+        entities[4].erase();
+        ASSERT_EQ(livingNames, 98);
+
+        for (int i = 0; i < 100; i++) {
+            Entity entity = createEntity();
+            entity.addComponent(OverAligned());
+            ASSERT_EQ(reinterpret_cast<std::uintptr_t>(entity.getComponent<OverAligned>()) % alignof(OverAligned), 0);
+        }
+    }
+
+    // the components of living entities got destroyed with the manager
+    ASSERT_EQ(livingNames, 0);
+}
+
+
+struct TagA {};
+
+struct Tagged {
+    int value = 0;
+};
+
+class TagListener :
+        public Listener <sEcs::ComponentAddedEvent<TagA>>,
+        public Listener <sEcs::ComponentDeletedEvent<TagA>> {
+
+public:
+    int added = 0;
+    int deleted = 0;
+
+    void  receive(const sEcs::ComponentAddedEvent<TagA>& event) override {
+        added++;
+    };
+
+    void  receive(const sEcs::ComponentDeletedEvent<TagA>& event) override {
+        deleted++;
+    };
+};
+
+TEST (ManagerTest, TestTagComponents) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Tag components" << endl;
+
+    registerComponent<TagA>();
+    registerComponent<Tagged>();
+
+    ASSERT_TRUE(manager.isTag(TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, TagA>()));
+    ASSERT_FALSE(manager.isTag(TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, Tagged>()));
+
+    // tags still emit their events to listeners
+    TagListener listener;
+    subscribeEvent<sEcs::ComponentAddedEvent<TagA>>(&listener);
+    subscribeEvent<sEcs::ComponentDeletedEvent<TagA>>(&listener);
+
+    SetIteratorId tagged = createSetIterator<TagA, Tagged>();
+    auto count = [&]() {
+        uint32 amount = 0;
+        while (manager.nextEntity(tagged).index != INVALID)
+            amount++;
+        return amount;
+    };
+
+    Entity first = createEntity();
+    first.addComponents(TagA(), Tagged());
+    Entity second = createEntity();
+    second.addComponent(Tagged());
+    second.addComponent(TagA());
+    second.addComponent(TagA());
+    Entity third = createEntity();
+    third.addComponent(TagA());
+
+    ASSERT_EQ(count(), 2);
+    ASSERT_TRUE(third.getComponent<TagA>() != nullptr);
+
+    third.deleteComponent<TagA>();
+    second.deleteComponent<TagA>();
+    ASSERT_TRUE(third.getComponent<TagA>() == nullptr);
+    ASSERT_EQ(count(), 1);
+
+    first.erase();
+    ASSERT_EQ(count(), 0);
+
+    // the second addition to second is replaced by a deleted and an added event
+    ASSERT_EQ(listener.added, 4);
+    ASSERT_EQ(listener.deleted, 4);
+
+}
+
+
+TEST (ManagerTest, TestMembershipsOfSharedComponents) {
+
+    Core core;
+
+    cout << "Memberships of sets with shared components" << endl;
+
+    ComponentId a = core.registerTagComponent();
+    ComponentId b = core.registerTagComponent();
+    ComponentId c = core.registerTagComponent();
+
+    SetIteratorId ab = core.createSetIterator({a, b});
+    SetIteratorId abc = core.createSetIterator({a, b, c});
+    SetIteratorId onlyC = core.createSetIterator({c});
+
+    auto count = [&](SetIteratorId setIteratorId) {
+        uint32 amount = 0;
+        while (core.nextEntity(setIteratorId).index != INVALID)
+            amount++;
+        return amount;
+    };
+
+    std::vector<ComponentId> all = {a, b, c};
+    EntityId first = core.createEntity();
+    EntityId second = core.createEntity();
+    core.activateComponents(first, &all.front(), 3);
+    core.activateComponents(second, &all.front(), 2);
+
+    ASSERT_EQ(count(ab), 2);
+    ASSERT_EQ(count(abc), 1);
+    ASSERT_EQ(count(onlyC), 1);
+
+    core.eraseEntity(first);    // leaves all sets at once
+
+    ASSERT_EQ(count(ab), 1);
+    ASSERT_EQ(count(abc), 0);
+    ASSERT_EQ(count(onlyC), 0);
+
+    core.deleteComponent(second, a);
+    ASSERT_EQ(count(ab), 0);
+
+}
+
+
+TEST (ManagerTest, TestRemovalWhileIterating) {
+
+    Core core;
+
+    cout << "Remove entities from a set while iterating" << endl;
+
+    ComponentId tag = core.registerTagComponent();
+    SetIteratorId tagged = core.createSetIterator({tag});
+
+    std::vector<EntityId> entities;
+    for (int i = 0; i < 1000; i++) {
+        entities.push_back(core.createEntity());
+        core.addComponent(entities.back(), tag);
+    }
+    ASSERT_EQ(core.getEntityAmount(tagged), 1000);
+
+    // erase the current and a not yet visited entity, every entity has to be visited exactly once
+    std::vector<int> visits(1000, 0);
+    for (EntityId entityId = core.nextEntity(tagged); entityId.index != INVALID; entityId = core.nextEntity(tagged)) {
+        visits[entityId.index - 1]++;
+        if (entityId.index % 4 == 1) {
+            core.eraseEntity(entityId);
+            if (entityId.index + 1 <= 1000)
+                core.deleteComponent(entities[entityId.index], tag);
+        }
+    }
+    for (int i = 0; i < 1000; i++)
+        ASSERT_EQ(visits[i], i % 4 == 1 ? 0 : 1);
+
+    ASSERT_EQ(core.getEntityAmount(tagged), 500);
+
+    uint32 amount = 0;
+    while (core.nextEntity(tagged).index != INVALID)
+        amount++;
+    ASSERT_EQ(amount, 500);
+
+    // a loop stopping early resets the iterator, the next one begins at the start
+    for (int i = 0; i < 10; i++)
+        core.nextEntity(tagged);
+    core.resetSetIterator(tagged);
+    core.eraseEntity(entities[999]);
+
+    amount = 0;
+    while (core.nextEntity(tagged).index != INVALID)
+        amount++;
+    ASSERT_EQ(amount, 499);
+
+}
+
+
+TEST (ManagerTest, TestGrowingEntityAmount) {
+
+    const uint32 maxAmount = 3 * ENTITY_PAGE_SIZE;
+    Core core(maxAmount);
+
+    cout << "Grow the entities on demand up to a soft maximum" << endl;
+
+    ComponentId sizeId = core.registerComponent(new ValuedComponentHandle(sizeof(Size), nullptr));
+    ComponentId sparseId = core.registerComponent(new SparseSetComponentHandle(sizeof(Size), nullptr, nullptr));
+    ComponentId pointingId = core.registerComponent(new PointingComponentHandle(sizeof(Size), nullptr));
+    SetIteratorId sized = core.createSetIterator({sizeId, sparseId, pointingId});
+
+    // pages already handed out keep their addresses while more get added
+    EntityId first = core.createEntity();
+    auto* firstSize = new(core.addComponent(first, sizeId)) Size(-1);
+    auto* firstPointed = new(core.addComponent(first, pointingId)) Size(-2);
+    new(core.addComponent(first, sparseId)) Size(-3);
+
+    std::vector<EntityId> entities;
+    for (uint32 i = 1; i < maxAmount; i++) {
+        entities.push_back(core.createEntity());
+        new(core.addComponent(entities.back(), sizeId)) Size(i);
+        new(core.addComponent(entities.back(), sparseId)) Size(i);
+        new(core.addComponent(entities.back(), pointingId)) Size(i);
+    }
+    ASSERT_EQ(core.getEntityAmount(), maxAmount);
+    ASSERT_EQ(core.getEntityAmount(sized), maxAmount);
+    ASSERT_EQ(core.getComponent(first, sizeId), firstSize);
+    ASSERT_EQ(core.getComponent(first, pointingId), firstPointed);
+    ASSERT_EQ(reinterpret_cast<Size*>(core.getComponent(first, sparseId))->size, -3);
+    for (uint32 i = 0; i < entities.size(); i++) {
+        ASSERT_EQ(reinterpret_cast<Size*>(core.getComponent(entities[i], sizeId))->size, i + 1);
+        ASSERT_EQ(reinterpret_cast<Size*>(core.getComponent(entities[i], sparseId))->size, i + 1);
+        ASSERT_EQ(reinterpret_cast<Size*>(core.getComponent(entities[i], pointingId))->size, i + 1);
+    }
+
+    // the maximum is reached
+    EntityId rejected = core.createEntity();
+    ASSERT_EQ(rejected.index, 0);
+    ASSERT_EQ(core.getIndex(rejected), INVALID);
+    ASSERT_EQ(core.getEntityAmount(), maxAmount);
+
+    // raising it allows more entities
+    core.setMaxEntityAmount(maxAmount + 10);
+    ASSERT_EQ(core.getMaxEntityAmount(), maxAmount + 10);
+    for (uint32 i = 0; i < 10; i++)
+        ASSERT_NE(core.createEntity().index, 0);
+    ASSERT_EQ(core.createEntity().index, 0);
+    ASSERT_EQ(core.getEntityAmount(), maxAmount + 10);
+
+    // lowering it only stops new indices, the freed ones still get reused
+    core.setMaxEntityAmount(maxAmount);
+    ASSERT_EQ(core.createEntity().index, 0);
+    core.eraseEntity(entities[5]);
+    EntityId reused = core.createEntity();
+    ASSERT_EQ(reused.index, entities[5].index);
+    ASSERT_EQ(core.createEntity().index, 0);
+    ASSERT_EQ(core.getEntityAmount(), maxAmount + 10);
+
+}
+
+
+TEST (ManagerTest, TestCreateEntitiesAtOnce) {
+
+    Core core(300);
+
+    cout << "Create entities at once" << endl;
+
+    ComponentId tag = core.registerTagComponent();
+    ComponentId sizeId = core.registerComponent(new ValuedComponentHandle(sizeof(Size), nullptr));
+    ComponentId positionId = core.registerArchetypeComponent(sizeof(Position), alignof(Position), nullptr, nullptr);
+
+    SetIteratorId tagged = core.createSetIterator({tag, sizeId});
+    SetIteratorId withoutTag = core.createSetIterator({sizeId}, {tag});
+    SetIteratorId positioned = core.createSetIterator({positionId});
+
+    std::vector<EntityId> single(10);
+    for (uint32 i = 0; i < 10; i++)
+        single[i] = core.createEntity();
+    core.eraseEntity(single[3]);
+    core.eraseEntity(single[7]);
+
+    std::vector<ComponentId> ids = {tag, sizeId, positionId};
+    std::vector<EntityId> created(200);
+    ASSERT_EQ(core.createEntities(200, &created.front(), &ids.front(), ids.size()), 200);
+    ASSERT_EQ(core.getEntityAmount(), 208);
+
+    // the free indices get reused first
+    ASSERT_EQ(created[0].index, single[7].index);
+    ASSERT_EQ(created[1].index, single[3].index);
+    ASSERT_NE(created[0].version, single[7].version);
+
+    for (uint32 i = 0; i < 200; i++) {
+        new(core.getComponent(created[i], sizeId)) Size(i);
+        new(core.getComponent(created[i], positionId)) Position{int(i), 0};
+    }
+    for (uint32 i = 0; i < 200; i++) {
+        ASSERT_EQ(reinterpret_cast<Size*>(core.getComponent(created[i], sizeId))->size, i);
+        ASSERT_EQ(reinterpret_cast<Position*>(core.getComponent(created[i], positionId))->x, i);
+    }
+
+    ASSERT_EQ(core.getEntityAmount(tagged), 200);
+    ASSERT_EQ(core.getEntityAmount(withoutTag), 0);
+    ASSERT_EQ(core.getEntityAmount(positioned), 200);
+
+    // the sets behave as if the entities were added one by one
+    core.deleteComponent(created[5], tag);
+    core.eraseEntity(created[6]);
+    ASSERT_EQ(core.getEntityAmount(tagged), 198);
+    ASSERT_EQ(core.getEntityAmount(withoutTag), 1);
+    ASSERT_EQ(core.getEntityAmount(positioned), 199);
+
+    uint32 amount = 0;
+    while (core.nextEntity(tagged).index != INVALID)
+        amount++;
+    ASSERT_EQ(amount, 198);
+
+    // each component can be passed only once, nothing is created then
+    std::vector<ComponentId> twice = {sizeId, positionId, sizeId};
+    ASSERT_THROW(core.createEntities(10, &created.front(), &twice.front(), twice.size()), std::invalid_argument);
+    ASSERT_EQ(core.getEntityAmount(), 207);
+
+    // only 300 entities are allowed
+    ASSERT_EQ(core.createEntities(200, &created.front()), 93);
+    ASSERT_EQ(core.getEntityAmount(), 300);
+    ASSERT_TRUE(core.getComponent(created[0], sizeId) == nullptr);
+
+}
+
+
+struct Health {
+    int points = 100;
+};
+
+TEST (ManagerTest, TestCreateTypedEntitiesAtOnce) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Create typed entities at once" << endl;
+
+    registerComponent<TagA>();
+    registerComponent<Health>();
+    registerComponent<Tagged>(Storing::SPARSE);
+
+    SetIteratorId all = createSetIterator<TagA, Health, Tagged>();
+
+    Health health;
+    health.points = 42;
+    std::vector<Entity> entities = createEntities(1000, health, TagA(), Tagged());
+    ASSERT_EQ(entities.size(), 1000);
+    ASSERT_EQ(manager.getEntityAmount(all), 1000);
+
+    for (Entity entity : entities) {
+        ASSERT_EQ(entity.getComponent<Health>()->points, 42);
+        ASSERT_EQ(entity.getComponent<Tagged>()->value, 0);
+        ASSERT_TRUE(entity.getComponent<TagA>() != nullptr);
+    }
+
+    ASSERT_EQ(createEntities(10).size(), 10);
+    ASSERT_EQ(countEntities(), 1010);
+
+}
+
+
+struct Counted {
+    static int living;
+    int value = 0;
+
+    Counted() { living++; }
+    Counted(const Counted& other) : value(other.value) { living++; }
+    ~Counted() { living--; }
+};
+
+int Counted::living = 0;
+
+TEST (ManagerTest, TestEraseEntitiesAtOnce) {
+
+    Core core;
+
+    cout << "Erase entities at once" << endl;
+
+    ComponentId tag = core.registerTagComponent();
+    ComponentId countedId = core.registerComponent(new SparseSetComponentHandle(sizeof(Counted),
+            [](void *p) { reinterpret_cast<Counted *>(p)->~Counted(); },
+            [](void *destination, void *source) {
+                new(destination) Counted(*reinterpret_cast<Counted *>(source));
+                reinterpret_cast<Counted *>(source)->~Counted();
+            }));
+    ComponentId positionId = core.registerArchetypeComponent(sizeof(Position), alignof(Position), nullptr, nullptr);
+
+    SetIteratorId tagged = core.createSetIterator({tag});
+    SetIteratorId counted = core.createSetIterator({countedId}, {tag});
+    SetIteratorId positioned = core.createSetIterator({positionId});
+
+    std::vector<EntityId> entities;
+    for (int i = 0; i < 100; i++) {
+        entities.push_back(core.createEntity());
+        new(core.addComponent(entities.back(), countedId)) Counted();
+        reinterpret_cast<Position*>(core.addComponent(entities.back(), positionId))->x = i;
+        if (i % 2 == 0)
+            core.addComponent(entities.back(), tag);
+    }
+    ASSERT_EQ(Counted::living, 100);
+
+    // duplicates and invalid ids are skipped
+    std::vector<EntityId> erased = {entities[0], entities[1], entities[0], EntityId(), entities[2]};
+    ASSERT_EQ(core.eraseEntities(&erased.front(), erased.size()), 3);
+    ASSERT_EQ(core.eraseEntities(&erased.front(), erased.size()), 0);
+    ASSERT_FALSE(core.isValid(entities[1]));
+    ASSERT_EQ(core.getEntityAmount(), 97);
+    ASSERT_EQ(Counted::living, 97);
+    ASSERT_EQ(core.getEntityAmount(tagged), 48);
+    ASSERT_EQ(core.getEntityAmount(counted), 49);
+    ASSERT_EQ(core.getEntityAmount(positioned), 97);
+
+    // the remaining archetype rows are still in place
+    for (int i = 3; i < 100; i++)
+        ASSERT_EQ(reinterpret_cast<Position*>(core.getComponent(entities[i], positionId))->x, i);
+
+    // all members of the set at once
+    ASSERT_EQ(core.clearQuery(tagged), 48);
+    ASSERT_EQ(core.getEntityAmount(tagged), 0);
+    ASSERT_EQ(core.getEntityAmount(counted), 49);
+    ASSERT_EQ(core.getEntityAmount(positioned), 49);
+    ASSERT_EQ(Counted::living, 49);
+
+    uint32 amount = 0;
+    while (core.nextEntity(counted).index != INVALID)
+        amount++;
+    ASSERT_EQ(amount, 49);
+
+    // the indices get reused
+    EntityId reused = core.createEntity();
+    ASSERT_LE(reused.index, 100);
+    ASSERT_EQ(core.getEntityAmount(), 50);
+
+    ASSERT_EQ(core.clearQuery(counted), 49);
+    ASSERT_EQ(Counted::living, 0);
+    ASSERT_EQ(core.getEntityAmount(), 1);
+
+}
+
+
+TEST (ManagerTest, TestEraseTypedEntitiesAtOnce) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Erase typed entities at once" << endl;
+
+    registerComponent<TagA>();
+    registerComponent<Health>();
+
+    SetIteratorId healthy = createSetIterator<Health>();
+
+    std::vector<Entity> tagged = createEntities(10, Health(), TagA());
+    std::vector<Entity> untagged = createEntities(20, Health());
+    createEntities(5);
+
+    ASSERT_EQ((eraseAll<Health, Without<TagA>>()), 20);
+    ASSERT_EQ(manager.getEntityAmount(healthy), 10);
+    ASSERT_FALSE(untagged[0].isValid());
+    ASSERT_TRUE(tagged[0].isValid());
+
+    ASSERT_EQ(eraseEntities(tagged), 10);
+    ASSERT_EQ(manager.getEntityAmount(healthy), 0);
+    ASSERT_EQ(countEntities(), 5);
+
+}
@@ -132,4 +132,670 @@ TEST (RtManagerTest, TestRtManagerEventHandler) {
     ASSERT_EQ(receiver.compAddedReceived, 3);
     ASSERT_EQ(receiver.entityCreated, 1);
 
-}
\ No newline at end of file
+}
+
+struct OverwrittenComponent {
+    int value;
+};
+
+class ReplaceReceiver :
+        public Listener <sEcs::ComponentAddedEvent<OverwrittenComponent>>,
+        public Listener <sEcs::ComponentReplacedEvent<OverwrittenComponent>> {
+
+public:
+    int compAddedReceived = 0;
+    int compReplacedReceived = 0;
+
+    void  receive(const sEcs::ComponentAddedEvent<OverwrittenComponent>& event) override {
+        compAddedReceived++;
+    };
+
+    void  receive(const sEcs::ComponentReplacedEvent<OverwrittenComponent>& event) override {
+        compReplacedReceived++;
+    };
+
+};
+
+TEST (RtManagerTest, TestReplaceEvents) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Overwrite trivially copyable components in place" << endl;
+
+    registerComponent<OverwrittenComponent>();
+    setReplaceEvents<OverwrittenComponent>(true);
+
+    ReplaceReceiver receiver;
+    subscribeEvent<sEcs::ComponentAddedEvent<OverwrittenComponent>>(&receiver);
+    subscribeEvent<sEcs::ComponentReplacedEvent<OverwrittenComponent>>(&receiver);
+
+    Entity entity = createEntity();
+    OverwrittenComponent* first = entity.addComponent(OverwrittenComponent{1});
+    OverwrittenComponent* second = entity.addComponent(OverwrittenComponent{2});
+    entity.addComponents(OverwrittenComponent{3});
+
+    ASSERT_EQ(first, second);
+    ASSERT_EQ(entity.getComponent<OverwrittenComponent>()->value, 3);
+    ASSERT_EQ(receiver.compAddedReceived, 1);
+    ASSERT_EQ(receiver.compReplacedReceived, 2);
+
+}
+
+struct CreatedComponent {
+    int x;
+};
+
+class BatchReceiver :
+        public Listener <sEcs::EntitiesCreatedEvent>,
+        public Listener <sEcs::EntitiesErasedEvent>,
+        public Listener <sEcs::ComponentAddedEvent<CreatedComponent>> {
+
+public:
+    int batches = 0;
+    int entitiesCreated = 0;
+    int compAddedReceived = 0;
+    int entitiesErased = 0;
+    int erasedWithComponent = 0;
+
+    void  receive(const sEcs::EntitiesCreatedEvent& event) override {
+        batches++;
+        entitiesCreated += event.amount;
+    };
+
+    void  receive(const sEcs::EntitiesErasedEvent& event) override {
+        batches++;
+        entitiesErased += event.amount;
+        for (uint32 i = 0; i < event.amount; i++)     // not erased yet
+            if (getEntity(event.entityIds[i]).getComponent<CreatedComponent>() != nullptr)
+                erasedWithComponent++;
+    };
+
+    void  receive(const sEcs::ComponentAddedEvent<CreatedComponent>& event) override {
+        compAddedReceived++;
+    };
+
+};
+
+TEST (RtManagerTest, TestEventsOfCreatedEntities) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Events of entities created at once" << endl;
+
+    registerComponent<CreatedComponent>();
+
+    BatchReceiver receiver;
+    subscribeEvent<sEcs::EntitiesCreatedEvent>(&receiver);
+
+    createEntities(100, CreatedComponent{1});
+    ASSERT_EQ(receiver.batches, 1);
+    ASSERT_EQ(receiver.entitiesCreated, 100);
+    ASSERT_EQ(receiver.compAddedReceived, 0);
+
+    // listeners of the single events still get one event per entity
+    SomeReceiver single;
+    subscribeEvent<sEcs::EntityCreatedEvent>(&single);
+    subscribeEvent<sEcs::ComponentAddedEvent<CreatedComponent>>(&receiver);
+
+    createEntities(50, CreatedComponent{2});
+    ASSERT_EQ(receiver.batches, 2);
+    ASSERT_EQ(receiver.entitiesCreated, 150);
+    ASSERT_EQ(receiver.compAddedReceived, 50);
+    ASSERT_EQ(single.entityCreated, 50);
+
+    std::vector<Entity> entities = createEntities(30);
+    subscribeEvent<sEcs::EntitiesErasedEvent>(&receiver);
+    ASSERT_EQ(eraseEntities(entities), 30);
+    ASSERT_EQ(eraseAll<CreatedComponent>(), 150);
+    ASSERT_EQ(receiver.batches, 5);
+    ASSERT_EQ(receiver.entitiesErased, 180);
+    ASSERT_EQ(receiver.erasedWithComponent, 150);
+
+}
+
+
+class ErasingReceiver : public Listener <sEcs::EntityErasedEvent> {
+
+public:
+    Entity other;
+    int received = 0;
+
+    void  receive(const sEcs::EntityErasedEvent& event) override {
+        received++;
+        Entity erased = other;
+        other = Entity();
+        if (erased.isValid())
+            erased.erase();
+    };
+
+};
+
+TEST (RtManagerTest, TestErasingWhileErasingEntities) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Listeners erase entities of the erased batch" << endl;
+
+    registerComponent<CreatedComponent>();
+
+    std::vector<Entity> entities = createEntities(10, CreatedComponent{1});
+    ErasingReceiver receiver;
+    receiver.other = entities[7];
+    subscribeEvent<sEcs::EntityErasedEvent>(&receiver);
+
+    ASSERT_EQ(eraseEntities(entities), 10);
+    ASSERT_EQ(receiver.received, 11);   // the entity erased by the listener emits its own event as well
+    ASSERT_EQ(manager.getEntityAmount(), 0);
+    ASSERT_EQ(countEntities<CreatedComponent>(), 0);
+
+    // every index is freed once
+    std::vector<Entity> created = createEntities(10);
+    std::set<EntityIndex> indices;
+    for (Entity entity : created)
+        indices.insert(entity.index());
+    ASSERT_EQ(indices.size(), 10);
+    ASSERT_EQ(manager.getEntityAmount(), 10);
+
+}
+
+
+struct QueuedEvent {
+    std::string name;   // not trivially copyable
+    int number;
+};
+
+struct ImmediateEvent {
+    int number;
+};
+
+class QueuedReceiver :
+        public Listener <QueuedEvent>,
+        public Listener <ImmediateEvent> {
+
+public:
+    int batches = 0;
+    vector<int> numbers;
+    int immediate = 0;
+    bool enqueueMore = false;
+
+    void  receive(const QueuedEvent& event) override {
+        numbers.push_back(event.number);
+    };
+
+    void  receiveAll(const QueuedEvent* events, uint32 amount) override {
+        batches++;
+        for (uint32 i = 0; i < amount; i++) {
+            ASSERT_EQ(events[i].name, "event " + std::to_string(events[i].number));
+            receive(events[i]);
+        }
+        if (enqueueMore) {
+            enqueueMore = false;
+            enqueueEvent(QueuedEvent{"event 100", 100});
+        }
+    };
+
+    void  receive(const ImmediateEvent& event) override {
+        immediate++;
+    };
+
+};
+
+TEST (RtManagerTest, TestQueuedEvents) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Queued events get dispatched at once" << endl;
+
+    // nobody listens yet
+    enqueueEvent(QueuedEvent{"event 0", 0});
+
+    QueuedReceiver receiver;
+    subscribeEvent<QueuedEvent>(&receiver);
+    subscribeEvent<ImmediateEvent>(&receiver);
+
+    for (int i = 1; i <= 50; i++)
+        enqueueEvent(QueuedEvent{"event " + std::to_string(i), i});
+    emitEvent(QueuedEvent{"event 51", 51});
+    emitEvent(ImmediateEvent{1});
+    ASSERT_EQ(receiver.batches, 0);
+    ASSERT_EQ(receiver.numbers.size(), 1);     // the emitted one
+    ASSERT_EQ(receiver.immediate, 1);
+
+    dispatchQueued();
+    ASSERT_EQ(receiver.batches, 1);
+    ASSERT_EQ(receiver.numbers.size(), 51);
+    for (int i = 1; i <= 50; i++)
+        ASSERT_EQ(receiver.numbers[i], i);
+
+    // emitEvent enqueues after setQueuedEvents, events of the listeners are dispatched next time
+    setQueuedEvents<QueuedEvent>(true);
+    setQueuedEvents<ImmediateEvent>(true);
+    receiver.enqueueMore = true;
+    emitEvent(QueuedEvent{"event 52", 52});
+    emitEvent(QueuedEvent{"event 53", 53});
+    emitEvent(ImmediateEvent{2});
+    ASSERT_EQ(receiver.batches, 1);
+    ASSERT_EQ(receiver.immediate, 1);
+
+    dispatchQueued<QueuedEvent>();
+    ASSERT_EQ(receiver.batches, 2);
+    ASSERT_EQ(receiver.numbers.back(), 53);
+    ASSERT_EQ(receiver.immediate, 1);
+
+    // update dispatches at the end
+    manager.update(0);
+    ASSERT_EQ(receiver.batches, 3);
+    ASSERT_EQ(receiver.numbers.back(), 100);
+    ASSERT_EQ(receiver.immediate, 2);
+
+    dispatchQueued();
+    ASSERT_EQ(receiver.batches, 3);
+
+    // queued events get destroyed with the manager
+    enqueueEvent(QueuedEvent{"event 101", 101});
+}
+
+
+struct ProducedEvent {
+    uint32 producer;
+    uint32 sequence;
+};
+
+class ProducedReceiver : public Events::Listener {
+
+public:
+    vector<uint32> received;    // by producer
+    uint32 total = 0;
+    bool ordered = true;
+
+    void receive(EventId eventId, const void* event) override {}
+
+    void receiveAll(EventId eventId, const void* events, uint32 amount, size_t size) override {
+        auto* produced = static_cast<const ProducedEvent*>(events);
+        for (uint32 i = 0; i < amount; i++) {
+            // ordered by producer within one collection and by sequence per producer
+            if (i > 0 && produced[i].producer < produced[i - 1].producer)
+                ordered = false;
+            if (produced[i].sequence != received[produced[i].producer]++)
+                ordered = false;
+        }
+        total += amount;
+    }
+
+};
+
+TEST (RtManagerTest, TestProducerThreads) {
+
+    Events::EventHandler handler;
+    EventId eventId = handler.generateEvent();
+
+    const uint32 producers = 8;
+    const uint32 perProducer = 50000;
+
+    cout << "Events of " << producers << " threads get collected in order, while they are published" << endl;
+
+    ProducedReceiver receiver;
+    receiver.received.resize(producers);
+    handler.subscribeEvent(eventId, &receiver);
+    handler.reserveProducers(producers);
+
+    std::atomic<uint32> finished(0);
+    vector<std::thread> threads;
+    for (uint32 p = 0; p < producers; p++)
+        threads.emplace_back([&, p]() {
+            Events::EventProducer& producer = handler.getProducer(p);
+            for (uint32 i = 0; i < perProducer; i++) {
+                new (producer.enqueueEvent(eventId, sizeof(ProducedEvent), alignof(ProducedEvent), nullptr, nullptr))
+                        ProducedEvent{p, i};
+                producer.publish();
+            }
+            finished++;
+        });
+
+    while (finished < producers)
+        handler.dispatchQueued();
+    for (std::thread& thread : threads)
+        thread.join();
+    handler.dispatchQueued();
+
+    ASSERT_TRUE(receiver.ordered);
+    ASSERT_EQ(receiver.total, producers * perProducer);
+    for (uint32 p = 0; p < producers; p++)
+        ASSERT_EQ(receiver.received[p], perProducer);
+
+}
+
+struct WorkerEvent {
+    int number;
+};
+
+class WorkerReceiver : public Listener <WorkerEvent> {
+
+public:
+    vector<int> numbers;
+
+    void  receive(const WorkerEvent& event) override {
+        numbers.push_back(event.number);
+    };
+
+};
+
+TEST (RtManagerTest, TestQueuedEventsOfWorkers) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Workers of the job system enqueue events" << endl;
+
+    WorkerReceiver receiver;
+    subscribeEvent<WorkerEvent>(&receiver);
+
+    manager.getJobSystem().parallelFor(1000, 10, [](uint32 begin, uint32 end) {
+        for (uint32 i = begin; i < end; i++)
+            enqueueEvent(WorkerEvent{static_cast<int>(i)});
+    });
+    dispatchQueued();
+
+    ASSERT_EQ(receiver.numbers.size(), 1000);
+    std::sort(receiver.numbers.begin(), receiver.numbers.end());
+    for (int i = 0; i < 1000; i++)
+        ASSERT_EQ(receiver.numbers[i], i);
+
+    // other threads have no producer
+    bool rejected = false;
+    std::thread other([&rejected]() {
+        try {
+            enqueueEvent(WorkerEvent{-1});
+        } catch (std::logic_error&) {
+            rejected = true;
+        }
+    });
+    other.join();
+    dispatchQueued();
+    ASSERT_TRUE(rejected);
+    ASSERT_EQ(receiver.numbers.size(), 1000);
+}
+
+
+struct DelegatedEvent {
+    int number;
+};
+
+int delegatedSum = 0;
+
+void addDelegated(const DelegatedEvent& event) {
+    delegatedSum += event.number;
+}
+
+class DelegatedReceiver {
+
+public:
+    int received = 0;
+    Subscription own;
+    Subscription other;
+    Subscription added;
+    bool unsubscribeOwn = false;
+    bool unsubscribeOther = false;
+    bool subscribeMore = false;
+
+    void onEvent(const DelegatedEvent& event) {
+        received++;
+        if (unsubscribeOwn) {
+            unsubscribeOwn = false;
+            unsubscribeEvent(own);
+        }
+        if (unsubscribeOther) {
+            unsubscribeOther = false;
+            unsubscribeEvent(other);
+        }
+        if (subscribeMore) {
+            subscribeMore = false;
+            added = subscribeEvent<DelegatedEvent, DelegatedReceiver, &DelegatedReceiver::onEvent>(this);
+        }
+    }
+
+};
+
+TEST (RtManagerTest, TestDelegates) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Delegates subscribe functions and methods" << endl;
+
+    Subscription function = subscribeEvent<DelegatedEvent, &addDelegated>();
+    DelegatedReceiver first;
+    DelegatedReceiver second;
+    first.own = subscribeEvent<DelegatedEvent, DelegatedReceiver, &DelegatedReceiver::onEvent>(&first);
+    second.own = subscribeEvent<DelegatedEvent, DelegatedReceiver, &DelegatedReceiver::onEvent>(&second);
+
+    emitEvent(DelegatedEvent{2});
+    ASSERT_EQ(delegatedSum, 2);
+    ASSERT_EQ(first.received, 1);
+    ASSERT_EQ(second.received, 1);
+
+    // unsubscribing twice is ignored, also if the handle got reused
+    unsubscribeEvent(function);
+    unsubscribeEvent(function);
+    Subscription again = subscribeEvent<DelegatedEvent, &addDelegated>();
+    unsubscribeEvent(function);
+    emitEvent(DelegatedEvent{3});
+    ASSERT_EQ(delegatedSum, 5);
+    unsubscribeEvent(again);
+
+    // Unsubscribing the function swapped the second delegate in front of the first one. While emitting, the
+    // second one unsubscribes itself and the first one, which doesn't get called anymore. A new delegate receives
+    // the next events.
+    second.unsubscribeOwn = true;
+    second.unsubscribeOther = true;
+    second.other = first.own;
+    second.subscribeMore = true;
+    emitEvent(DelegatedEvent{4});
+    ASSERT_EQ(delegatedSum, 5);
+    ASSERT_EQ(second.received, 3);
+    ASSERT_EQ(first.received, 2);
+
+    emitEvent(DelegatedEvent{5});
+    ASSERT_EQ(second.received, 4);      // only the added one
+    ASSERT_EQ(first.received, 2);
+
+    // queued events are handed to delegates one by one
+    setQueuedEvents<DelegatedEvent>(true);
+    emitEvent(DelegatedEvent{6});
+    emitEvent(DelegatedEvent{7});
+    ASSERT_EQ(second.received, 4);
+    dispatchQueued();
+    ASSERT_EQ(second.received, 6);
+
+    unsubscribeEvent(second.added);
+    ASSERT_FALSE(manager.hasListeners(TypeWrapper_Intern::getGenerateEventId<DelegatedEvent>()));
+}
+
+
+struct ToggledComponent {
+    int x;
+};
+
+class ToggledReceiver :
+        public Listener <sEcs::ComponentAddedEvent<ToggledComponent>>,
+        public Listener <sEcs::ComponentDeletedEvent<ToggledComponent>> {
+
+public:
+    int added = 0;
+    int deleted = 0;
+
+    void  receive(const sEcs::ComponentAddedEvent<ToggledComponent>& event) override {
+        added++;
+    };
+
+    void  receive(const sEcs::ComponentDeletedEvent<ToggledComponent>& event) override {
+        deleted++;
+    };
+
+};
+
+TEST (RtManagerTest, TestComponentEventToggles) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Component events get switched off and on" << endl;
+
+    registerComponent<ToggledComponent>();
+    EventId addedId = manager.componentAddedEventId(TypeWrapper_Intern::getSetId<ConceptType::COMPONENT, ToggledComponent>());
+
+    ToggledReceiver receiver;
+    ASSERT_FALSE(manager.hasListeners(addedId));
+    subscribeEvent<sEcs::ComponentAddedEvent<ToggledComponent>>(&receiver);
+    subscribeEvent<sEcs::ComponentDeletedEvent<ToggledComponent>>(&receiver);
+    ASSERT_TRUE(manager.hasListeners(addedId));
+
+    Entity entity = createEntity();
+    entity.addComponent(ToggledComponent{1});
+    ASSERT_EQ(receiver.added, 1);
+
+    setComponentEvents<ToggledComponent>(false);
+    entity.deleteComponent<ToggledComponent>();
+    entity.addComponent(ToggledComponent{2});
+    createEntities(10, ToggledComponent{3});
+    eraseAll<ToggledComponent>();
+    ASSERT_EQ(receiver.added, 1);
+    ASSERT_EQ(receiver.deleted, 0);
+
+    setComponentEvents<ToggledComponent>(true);
+    createEntity().addComponent(ToggledComponent{4});
+    createEntities(10, ToggledComponent{5});
+    eraseAll<ToggledComponent>();
+    ASSERT_EQ(receiver.added, 12);
+    ASSERT_EQ(receiver.deleted, 11);
+
+    unsubscribeEvent<sEcs::ComponentAddedEvent<ToggledComponent>>(&receiver);
+    ASSERT_FALSE(manager.hasListeners(addedId));
+}
+
+
+struct WatchedHealth {
+    int value;
+};
+
+struct WatchedPlayer {};
+
+struct WatchedGhost {};
+
+class HealthWidget {
+
+public:
+    std::vector<EntityId> added;
+    std::vector<EntityId> deleted;
+    std::vector<EntityId> erased;
+
+    void onAdded(const sEcs::ComponentAddedEvent<WatchedHealth>& event) {
+        added.push_back(event.entityId);
+    }
+
+    void onDeleted(const sEcs::ComponentDeletedEvent<WatchedHealth>& event) {
+        deleted.push_back(event.entityId);
+    }
+
+    void onErased(const EntityErasedEvent& event) {
+        erased.push_back(event.entityId);
+    }
+};
+
+TEST (RtManagerTest, TestEntitySubscriptions) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Delegates only receive the events of their entities" << endl;
+
+    registerComponent<WatchedHealth>();
+    registerComponent<WatchedPlayer>();
+    registerComponent<WatchedGhost>();
+
+    vector<Entity> entities;
+    for (int i = 0; i < 100; i++)
+        entities.push_back(createEntity());
+
+    HealthWidget single;
+    subscribeEvent<sEcs::ComponentAddedEvent<WatchedHealth>, HealthWidget, &HealthWidget::onAdded>(&single, entities[3]);
+    Subscription deleted = subscribeEvent<sEcs::ComponentDeletedEvent<WatchedHealth>, HealthWidget,
+            &HealthWidget::onDeleted>(&single, entities[3]);
+    subscribeEvent<EntityErasedEvent, HealthWidget, &HealthWidget::onErased>(&single, entities[3]);
+
+    HealthWidget several;
+    vector<Subscription> subscriptions = subscribeEvent<sEcs::ComponentAddedEvent<WatchedHealth>, HealthWidget,
+            &HealthWidget::onAdded>(&several, {entities[5], entities[6], entities[7]});
+    subscribeEvent<EntityErasedEvent, HealthWidget, &HealthWidget::onErased>(&several, {entities[5], entities[6]});
+
+    // invalid entities don't get subscriptions
+    Entity invalid = createEntity();
+    invalid.erase();
+    Subscription none = subscribeEvent<sEcs::ComponentAddedEvent<WatchedHealth>, HealthWidget,
+            &HealthWidget::onAdded>(&single, invalid);
+    ASSERT_EQ(none.eventId, 0);
+
+    for (Entity& entity : entities)
+        entity.addComponent(WatchedHealth{10});
+    ASSERT_EQ(single.added.size(), 1);
+    ASSERT_EQ(single.added[0], entities[3].id());
+    ASSERT_EQ(several.added.size(), 3);
+    ASSERT_EQ(several.added[2], entities[7].id());
+
+    unsubscribeEvent(subscriptions[2]);
+    entities[7].addComponent(WatchedHealth{20});    // replaced by a deleted and an added event
+    entities[3].addComponent(WatchedHealth{20});
+    ASSERT_EQ(several.added.size(), 3);
+    ASSERT_EQ(single.added.size(), 2);
+    ASSERT_EQ(single.deleted.size(), 1);
+
+    // erasing the entity unsubscribes its delegates after the last events, the index gets reused
+    entities[3].erase();
+    ASSERT_EQ(single.deleted.size(), 2);
+    ASSERT_EQ(single.erased.size(), 1);
+    Entity reused = createEntity();
+    ASSERT_EQ(reused.id().index, entities[3].id().index);
+    reused.addComponent(WatchedHealth{30});
+    reused.erase();
+    ASSERT_EQ(single.added.size(), 2);
+    ASSERT_EQ(single.deleted.size(), 2);
+    ASSERT_EQ(single.erased.size(), 1);
+    unsubscribeEvent(deleted);      // already gone
+
+    std::vector<Entity> erased{entities[5], entities[6], entities[8]};
+    eraseEntities(erased);
+    ASSERT_EQ(several.erased.size(), 2);
+    ASSERT_FALSE(manager.hasListeners(TypeWrapper_Intern::getGenerateEventId<EntityErasedEvent>()));
+    ASSERT_FALSE(manager.hasListeners(
+            TypeWrapper_Intern::getGenerateEventId<sEcs::ComponentAddedEvent<WatchedHealth>>()));
+
+    // queries are checked when the event gets emitted
+    HealthWidget players;
+    Subscription query = subscribeEvent<sEcs::ComponentDeletedEvent<WatchedHealth>, HealthWidget,
+            &HealthWidget::onDeleted>(&players, Query<WatchedPlayer, Without<WatchedGhost>>());
+    for (int i = 10; i < 20; i++)
+        entities[i].addComponent(WatchedPlayer());
+    entities[15].addComponent(WatchedGhost());
+    for (int i = 9; i < 30; i++)
+        entities[i].deleteComponent<WatchedHealth>();
+    ASSERT_EQ(players.deleted.size(), 9);
+    ASSERT_EQ(players.deleted[0], entities[10].id());
+
+    unsubscribeEvent(query);
+    entities[30].erase();
+    ASSERT_EQ(players.deleted.size(), 9);
+    ASSERT_FALSE(manager.hasListeners(
+            TypeWrapper_Intern::getGenerateEventId<sEcs::ComponentDeletedEvent<WatchedHealth>>()));
+
+    // other events don't start with the id of a single entity
+    Events::Delegate ignored{[](void*, const void*) {}, nullptr};
+    ASSERT_THROW(manager.subscribeEntityEvent(manager.entitiesErasedEventId(), {}, {}, ignored),
+                 std::invalid_argument);
+    ASSERT_THROW(manager.subscribeEntityEvent(manager.generateEvent("UnfilteredEvent"), {}, {}, ignored),
+                 std::invalid_argument);
+    ASSERT_FALSE(manager.hasListeners(manager.entitiesErasedEventId()));
+}
@@ -2,6 +2,8 @@
 // Created by kreischenderdepp on 02.05.20.
 //
 
+#include <atomic>
+#include <set>
 #include <thread>
 
 #include <SimpleECS/Core.h>
@@ -17,4 +19,11 @@ struct Numbered {
 
 #include "BitsetTest.cc"
 #include "CoreTest.cc"
-#include "EventsTest.cc"
\ No newline at end of file
+#include "EventsTest.cc"
+#include "ArchetypeTest.cc"
+#include "ViewTest.cc"
+#include "SystemsTest.cc"
+#include "JobSystemTest.cc"
+#include "CommandBufferTest.cc"
+#include "ChangeDetectionTest.cc"
+#include "ObserverTest.cc"
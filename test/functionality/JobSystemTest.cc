@@ -0,0 +1,87 @@
+using std::cout;
+using std::endl;
+using std::vector;
+
+using namespace sEcs;
+
+
+TEST (JobSystemTest, TestJobCounters) {
+
+    JobSystem jobSystem(4);
+
+    cout << "Jobs submitting jobs with one counter" << endl;
+
+    ASSERT_EQ(jobSystem.getThreadAmount(), 4);
+    ASSERT_EQ(jobSystem.getThreadIndex(), 0);
+
+    std::atomic<int> executed(0);
+    std::atomic<bool> validIndices(true);
+    JobCounter counter;
+    for (int i = 0; i < 100; i++)
+        jobSystem.submit([&]() {
+            for (int j = 0; j < 10; j++)
+                jobSystem.submit([&]() {
+                    uint32 index = jobSystem.getThreadIndex();
+                    if (index > 4)
+                        validIndices = false;
+                    executed++;
+                }, counter);
+            executed++;
+        }, counter);
+
+    jobSystem.wait(counter);
+    ASSERT_TRUE(counter.isDone());
+    ASSERT_EQ(executed, 1100);
+    ASSERT_TRUE(validIndices);
+
+}
+
+
+TEST (JobSystemTest, TestWaitWithinJobs) {
+
+    JobSystem jobSystem(2);
+
+    cout << "Waiting within jobs executes other jobs meanwhile" << endl;
+
+    // more waiting jobs than workers, only possible if waiting threads help
+    std::atomic<int> summed(0);
+    JobCounter outer;
+    for (int i = 0; i < 8; i++)
+        jobSystem.submit([&]() {
+            jobSystem.parallelFor(1000, 10, [&](uint32 begin, uint32 end) {
+                summed += end - begin;
+            });
+        }, outer);
+    jobSystem.wait(outer);
+
+    ASSERT_EQ(summed, 8000);
+
+}
+
+
+TEST (JobSystemTest, TestJobExceptions) {
+
+    JobSystem jobSystem(3);
+
+    cout << "Exceptions of jobs are rethrown by wait" << endl;
+
+    std::atomic<int> executed(0);
+    JobCounter counter;
+    for (int i = 0; i < 50; i++)
+        jobSystem.submit([&executed, i]() {
+            executed++;
+            if (i % 10 == 0)
+                throw std::runtime_error("job failed");
+        }, counter);
+
+    ASSERT_THROW(jobSystem.wait(counter), std::runtime_error);
+    ASSERT_EQ(executed, 50);
+
+    jobSystem.wait(counter);    // rethrown once
+
+    ASSERT_THROW(jobSystem.parallelFor(100, 1, [](uint32 begin, uint32 end) {
+        if (begin == 42)
+            throw std::runtime_error("chunk failed");
+    }), std::runtime_error);
+
+}
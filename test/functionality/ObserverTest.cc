@@ -0,0 +1,132 @@
+using std::cout;
+using std::endl;
+using std::vector;
+
+using namespace sEcs;
+
+struct Observed {
+    int value = 0;
+};
+
+struct ObservedTag {};
+
+
+TEST (ObserverTest, TestDeliveredAtOnce) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Observations get delivered at once" << endl;
+
+    registerComponent<Observed>();
+    registerComponent<ObservedTag>(Storing::TAG);
+
+    vector<EntityId> added;
+    vector<EntityId> removed;
+    int addedCalls = 0;
+    int removedCalls = 0;
+    ObserverId observer = observe<Observed>(
+            [&](const EntityId* entityIds, uint32 amount) {
+                addedCalls++;
+                added.insert(added.end(), entityIds, entityIds + amount);
+            },
+            [&](const EntityId* entityIds, uint32 amount) {
+                removedCalls++;
+                removed.insert(removed.end(), entityIds, entityIds + amount);
+            });
+
+    vector<Entity> entities = createEntities(10, Observed());
+    Entity single = createEntity();
+    single.addComponent(Observed());
+    Entity tagged = createEntity();
+    tagged.addComponents(ObservedTag(), Observed());
+    createEntity().addComponent(ObservedTag());     // not observed
+
+    // nothing is delivered before the sync point
+    ASSERT_EQ(addedCalls, 0);
+    manager.update(0);
+    ASSERT_EQ(addedCalls, 1);
+    ASSERT_EQ(removedCalls, 0);
+    ASSERT_EQ(added.size(), 12);
+    ASSERT_EQ(added[0], entities[0].id());
+    ASSERT_EQ(added[10], single.id());
+    ASSERT_EQ(added[11], tagged.id());
+
+    // overwriting isn't an addition
+    single.addComponent(Observed());
+    deliverObservations();
+    ASSERT_EQ(addedCalls, 1);
+
+    single.deleteComponent<Observed>();
+    tagged.erase();
+    std::vector<Entity> erased(entities.begin(), entities.begin() + 5);
+    eraseEntities(erased);
+    entities[5].deleteComponent<ObservedTag>();     // doesn't have it
+    deliverObservations();
+    ASSERT_EQ(removedCalls, 1);
+    ASSERT_EQ(removed.size(), 7);
+    ASSERT_EQ(removed[0], single.id());
+    ASSERT_EQ(removed[1], tagged.id());
+
+    // an entity which got and lost the component is in both
+    added.clear();
+    removed.clear();
+    Entity shortLived = createEntity();
+    shortLived.addComponent(Observed());
+    shortLived.erase();
+    deliverObservations();
+    ASSERT_EQ(added.size(), 1);
+    ASSERT_EQ(removed.size(), 1);
+    ASSERT_EQ(added[0], removed[0]);
+
+    unobserve(observer);
+    createEntities(3, Observed());
+    entities[6].erase();
+    deliverObservations();
+    ASSERT_EQ(addedCalls, 2);
+    ASSERT_EQ(removedCalls, 2);
+}
+
+
+TEST (ObserverTest, TestChangesWhileDelivering) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Observers change entities while their observations get delivered" << endl;
+
+    registerComponent<Observed>();
+
+    // The second observer removes itself, the first one changes the observed entities
+    uint32 firstAdded = 0;
+    uint32 firstRemoved = 0;
+    uint32 secondAdded = 0;
+    ObserverId second = INVALID;
+    observe<Observed>(
+            [&](const EntityId* entityIds, uint32 amount) {
+                firstAdded += amount;
+                for (uint32 i = 0; i < amount; i++)
+                    Entity(entityIds[i]).deleteComponent<Observed>();
+            },
+            [&](const EntityId* entityIds, uint32 amount) {
+                firstRemoved += amount;
+            });
+    second = observe<Observed>([&](const EntityId* entityIds, uint32 amount) {
+        secondAdded += amount;
+        unobserve(second);
+    });
+
+    createEntities(4, Observed());
+    deliverObservations();
+    ASSERT_EQ(firstAdded, 4);
+    ASSERT_EQ(secondAdded, 4);
+    // the removals of the callback get delivered next time
+    ASSERT_EQ(firstRemoved, 0);
+    deliverObservations();
+    ASSERT_EQ(firstRemoved, 4);
+
+    createEntities(2, Observed());
+    deliverObservations();
+    ASSERT_EQ(firstAdded, 6);
+    ASSERT_EQ(secondAdded, 4);
+}
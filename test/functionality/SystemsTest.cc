@@ -0,0 +1,363 @@
+using std::cout;
+using std::endl;
+using std::vector;
+
+using namespace sEcs;
+
+struct ScheduledA {
+    int value = 0;
+};
+
+struct ScheduledB {
+    int value = 0;
+};
+
+std::atomic<int> runningSystems(0);
+std::atomic<int> finishedSystems(0);
+
+class WriteASystem : public IterateAllSystem<ScheduledA> {
+
+public:
+    int finishedBefore = -1;
+
+    void start(DELTA_TYPE delta) override {
+        runningSystems++;
+    }
+
+    void update(Entity entity, DELTA_TYPE delta) override {
+        entity.getComponent<ScheduledA>()->value++;
+    }
+
+    void end(DELTA_TYPE delta) override {
+        runningSystems--;
+        finishedBefore = finishedSystems++;
+    }
+
+};
+
+class WriteBSystem : public IterateAllSystem<ScheduledB> {
+
+public:
+    void start(DELTA_TYPE delta) override {
+        runningSystems++;
+    }
+
+    void update(Entity entity, DELTA_TYPE delta) override {
+        entity.getComponent<ScheduledB>()->value++;
+    }
+
+    void end(DELTA_TYPE delta) override {
+        runningSystems--;
+        finishedSystems++;
+    }
+
+};
+
+class ReadAWriteBSystem : public IterateAllSystem<const ScheduledA, ScheduledB> {
+
+public:
+    int startedAfter = -1;
+    bool sawUpdatedA = true;
+
+    void start(DELTA_TYPE delta) override {
+        startedAfter = finishedSystems;
+    }
+
+    void update(Entity entity, DELTA_TYPE delta) override {
+        if (entity.getComponent<ScheduledA>()->value != entity.getComponent<ScheduledB>()->value)
+            sawUpdatedA = false;
+        entity.getComponent<ScheduledB>()->value = 0;
+    }
+
+};
+
+class ExclusiveSystem : public System {
+
+public:
+    bool ranAlone = true;
+
+    void update(DELTA_TYPE delta) override {
+        if (runningSystems != 0)
+            ranAlone = false;
+    }
+
+};
+
+class ThrowingSystem : public System {
+
+public:
+    ThrowingSystem() {
+        declareRead(1);
+    }
+
+    void update(DELTA_TYPE delta) override {
+        throw std::runtime_error("system failed");
+    }
+
+};
+
+
+TEST (SystemsTest, TestSystemAccessConflicts) {
+
+    cout << "Conflicts of declared component access" << endl;
+
+    SystemAccess reading;
+    reading.declared = true;
+    reading.reads.set(1);
+
+    SystemAccess otherReading = reading;
+    SystemAccess writing;
+    writing.declared = true;
+    writing.writes.set(1);
+    SystemAccess writingOther;
+    writingOther.declared = true;
+    writingOther.writes.set(2);
+
+    ASSERT_FALSE(reading.conflicts(otherReading));
+    ASSERT_TRUE(reading.conflicts(writing));
+    ASSERT_TRUE(writing.conflicts(reading));
+    ASSERT_FALSE(writing.conflicts(writingOther));
+    ASSERT_TRUE(writing.conflicts(SystemAccess()));     // undeclared
+
+    writingOther.exclusive = true;
+    ASSERT_TRUE(writing.conflicts(writingOther));
+
+}
+
+
+TEST (SystemsTest, TestParallelUpdate) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Run systems concurrently by their declared access" << endl;
+
+    registerComponent<ScheduledA>();
+    registerComponent<ScheduledB>();
+
+    for (int i = 0; i < 1000; i++)
+        createEntity().addComponents(ScheduledA(), ScheduledB());
+
+    auto writeA = addSystem(std::make_shared<WriteASystem>());
+    auto writeB = addSystem(std::make_shared<WriteBSystem>());
+    auto readAWriteB = addSystem(std::make_shared<ReadAWriteBSystem>());
+    auto exclusive = addSystem(std::make_shared<ExclusiveSystem>());
+
+    manager.setParallelUpdate(true, 4);
+
+    for (int frame = 0; frame < 20; frame++) {
+        finishedSystems = 0;
+        updateEcs(0.0f);
+
+        ASSERT_EQ(readAWriteB->startedAfter, 2);     // after both writers
+        ASSERT_TRUE(exclusive->ranAlone);
+        each<ScheduledA>([&](ScheduledA& a) { a.value = 0; });
+    }
+    ASSERT_TRUE(readAWriteB->sawUpdatedA);
+
+    addSystem(std::make_shared<ThrowingSystem>());
+    ASSERT_THROW(updateEcs(0.0f), std::runtime_error);
+
+    manager.setParallelUpdate(false);
+    ASSERT_THROW(updateEcs(0.0f), std::runtime_error);
+
+}
+
+
+struct SharedRead {
+    int value = 1;
+};
+
+class SharedReadSystem : public IterateAllSystem<const SharedRead> {
+
+public:
+    int sum = 0;
+
+    void start(DELTA_TYPE delta) override {
+        sum = 0;
+    }
+
+    void update(Entity entity, DELTA_TYPE delta) override {
+        sum += entity.getComponent<SharedRead>()->value;
+    }
+
+};
+
+class FirstReadSystem : public SharedReadSystem {};
+
+class SecondReadSystem : public SharedReadSystem {};
+
+
+TEST (SystemsTest, TestParallelReadingSystems) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Iterate the same query in concurrent systems" << endl;
+
+    registerComponent<SharedRead>();
+
+    vector<Entity> entities;
+    for (int i = 0; i < 1000; i++) {
+        entities.push_back(createEntity());
+        entities.back().addComponent(SharedRead());
+    }
+
+    auto first = addSystem(std::make_shared<FirstReadSystem>());
+    auto second = addSystem(std::make_shared<SecondReadSystem>());
+    ASSERT_FALSE(first->getAccess().conflicts(second->getAccess()));
+
+    manager.setParallelUpdate(true, 4);
+
+    SetIteratorId erasing = createSetIterator<SharedRead>();
+    int expected = 1000;
+    for (int frame = 0; frame < 50; frame++) {
+        updateEcs(0.0f);
+        ASSERT_EQ(first->sum, expected);
+        ASSERT_EQ(second->sum, expected);
+
+        // erasing while iterating leaves holes, which have to be filled after the iteration
+        int visited = 0;
+        for (EntityId entityId = manager.nextEntity(erasing); entityId.index != INVALID;
+                entityId = manager.nextEntity(erasing)) {
+            if (visited++ % 50 == 0) {
+                manager.eraseEntity(entityId);
+                expected--;
+            }
+        }
+    }
+    ASSERT_EQ(manager.getEntityAmount(erasing), (uint32) expected);
+
+    manager.setParallelUpdate(false);
+
+}
+
+
+struct ParallelValue {
+    int value = 0;
+};
+
+struct ParallelChunked {
+    int value = 0;
+};
+
+struct ParallelMarked {};
+
+
+TEST (SystemsTest, TestParallelPass) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Parallel passes over views" << endl;
+
+    registerComponent<ParallelValue>();
+    registerComponent<ParallelChunked>(Storing::ARCHETYPE);
+
+    vector<Entity> entities;
+    for (int i = 0; i < 10000; i++) {
+        entities.push_back(createEntity());
+        entities.back().addComponent(ParallelValue());
+        if (i % 3 == 0)
+            entities.back().addComponent(ParallelChunked());
+    }
+    for (int i = 0; i < 10000; i += 7)     // leaves the dense list unordered
+        entities[i].deleteComponent<ParallelValue>();
+
+    auto values = view<ParallelValue>();
+    values.eachParallel([](ParallelValue& value) { value.value++; }, 64);
+    values.eachParallel([](EntityId entityId, ParallelValue& value) { value.value += entityId.index; }, 64);
+
+    for (int i = 0; i < 10000; i++) {
+        if (i % 7 == 0)
+            ASSERT_TRUE(entities[i].getComponent<ParallelValue>() == nullptr);
+        else
+            ASSERT_EQ(entities[i].getComponent<ParallelValue>()->value, 1 + (int) entities[i].id().index);
+    }
+
+    std::atomic<int> visited(0);
+    auto chunked = view<ParallelChunked>();
+    chunked.eachParallel([&](ParallelChunked& chunk) {
+        chunk.value++;
+        visited++;
+    });
+    ASSERT_EQ(visited, 3334);
+    for (int i = 0; i < 10000; i += 3)
+        ASSERT_EQ(entities[i].getComponent<ParallelChunked>()->value, 1);
+
+    ASSERT_THROW(values.eachParallel([](ParallelValue& value) {
+        if (value.value % 2 == 0)
+            throw std::runtime_error("pass failed");
+    }), std::runtime_error);
+    ASSERT_EQ(values.count(), 10000 - 1429);
+
+}
+
+
+class MarkingSystem : public ParallelIterateAllSystem<ParallelValue> {
+
+public:
+    MarkingSystem() : ParallelIterateAllSystem(16) {}
+
+    std::thread::id owner;
+    bool ownedStart = false;
+    bool ownedEnd = false;
+    std::atomic<int> updated;
+
+    void start(DELTA_TYPE delta) override {
+        ownedStart = std::this_thread::get_id() == owner;
+        updated = 0;
+    }
+
+    void update(Entity entity, DELTA_TYPE delta) override {
+        updated++;
+        if (entity.getComponent<ParallelValue>()->value % 2 == 0)
+            commands().addComponent(entity, ParallelMarked());
+        else
+            commands().eraseEntity(entity);
+    }
+
+    void end(DELTA_TYPE delta) override {
+        ownedEnd = std::this_thread::get_id() == owner;
+    }
+
+};
+
+
+TEST (SystemsTest, TestParallelIterateAllSystem) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Parallel systems record structural changes" << endl;
+
+    registerComponent<ParallelValue>();
+    registerComponent<ParallelMarked>();
+
+    vector<Entity> entities;
+    for (int i = 0; i < 5000; i++) {
+        entities.push_back(createEntity());
+        entities.back().addComponent(ParallelValue())->value = i;
+    }
+
+    auto marking = addSystem(std::make_shared<MarkingSystem>());
+    marking->owner = std::this_thread::get_id();
+    ASSERT_TRUE(marking->getAccess().exclusive);     // the playback changes the structure of entities
+    updateEcs(0.0f);
+
+    ASSERT_TRUE(marking->ownedStart);
+    ASSERT_TRUE(marking->ownedEnd);
+    ASSERT_EQ(marking->updated, 5000);
+    ASSERT_EQ(manager.getEntityAmount(), 2500);
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_EQ(entities[i].isValid(), i % 2 == 0);
+        if (i % 2 == 0) {
+            ASSERT_TRUE(entities[i].getComponent<ParallelMarked>() != nullptr);
+        }
+    }
+
+    updateEcs(0.0f);
+    ASSERT_EQ(marking->updated, 2500);
+    ASSERT_EQ(manager.getEntityAmount(), 2500);
+
+}
@@ -0,0 +1,315 @@
+using std::cout;
+using std::endl;
+using std::vector;
+
+using namespace sEcs;
+
+struct ViewPosition {
+    float x = 0, y = 0;
+};
+
+struct ViewVelocity {
+    float x = 0, y = 0;
+};
+
+struct ViewMarker {};
+
+
+TEST (ViewTest, TestEach) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Iterate typed views" << endl;
+
+    registerComponent<ViewPosition>();
+    registerComponent<ViewVelocity>(Storing::SPARSE);
+    registerComponent<ViewMarker>();
+
+    vector<Entity> entities;
+    for (int i = 0; i < 100; i++) {
+        Entity entity = createEntity();
+        entity.addComponent(ViewPosition());
+        if (i % 2 == 0)
+            entity.addComponent(ViewVelocity{float(i), 1});
+        if (i % 5 == 0)
+            entity.addComponent(ViewMarker());
+        entities.push_back(entity);
+    }
+
+    View<ViewVelocity, ViewPosition> moving = view<ViewVelocity, ViewPosition>();
+    ASSERT_EQ(moving.count(), 50);
+
+    moving.each([](ViewVelocity& velocity, ViewPosition& position) {
+        position.x += velocity.x;
+        position.y += velocity.y;
+    });
+
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(entities[i].getComponent<ViewPosition>()->x, i % 2 == 0 ? i : 0);
+        ASSERT_EQ(entities[i].getComponent<ViewPosition>()->y, i % 2 == 0 ? 1 : 0);
+    }
+
+    uint32 marked = 0;
+    each<ViewMarker, ViewPosition>([&](EntityId entityId, ViewMarker&, ViewPosition&) {
+        ASSERT_EQ((entityId.index - entities[0].index()) % 5, 0);
+        marked++;
+    });
+    ASSERT_EQ(marked, 20);
+
+    uint32 chunked = 0;
+    moving.eachChunk([&](uint32 amount, ViewVelocity* velocities, ViewPosition* positions) {
+        chunked += amount;
+    });
+    ASSERT_EQ(chunked, 50);
+
+}
+
+
+struct ChunkPosition {
+    float x = 0;
+};
+
+struct ChunkVelocity {
+    float x = 1;
+};
+
+TEST (ViewTest, TestEachChunk) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Iterate archetype chunks" << endl;
+
+    registerComponent<ChunkPosition>(Storing::ARCHETYPE);
+    registerComponent<ChunkVelocity>(Storing::ARCHETYPE);
+
+    for (int i = 0; i < 5000; i++) {
+        Entity entity = createEntity();
+        entity.addComponent(ChunkPosition());
+        if (i % 3 != 0)
+            entity.addComponent(ChunkVelocity());
+    }
+
+    View<ChunkPosition, ChunkVelocity> moving = view<ChunkPosition, ChunkVelocity>();
+
+    uint32 spans = 0;
+    uint32 amount = 0;
+    moving.eachChunk([&](uint32 spanAmount, ChunkPosition* positions, ChunkVelocity* velocities) {
+        for (uint32 i = 0; i < spanAmount; i++)
+            positions[i].x += velocities[i].x;
+        amount += spanAmount;
+        spans++;
+    });
+
+    ASSERT_EQ(amount, 3333);
+    ASSERT_LT(spans, amount / 10);   // contiguous spans instead of single entities
+
+    uint32 moved = 0;
+    each<ChunkPosition>([&](ChunkPosition& position) {
+        if (position.x == 1)
+            moved++;
+    });
+    ASSERT_EQ(moved, 3333);
+
+}
+
+
+struct QueryBody {
+    int size = 1;
+};
+
+struct QueryParticle {
+    int lifetime = 0;
+};
+
+struct QueryMovement {
+    float speed = 0;
+};
+
+struct QueryStatic {};
+
+class CountingSystem : public IterateAllSystem<QueryBody, Without<QueryParticle>> {
+
+public:
+    uint32 counted = 0;
+
+    void update(Entity entity, DELTA_TYPE delta) override {
+        ASSERT_TRUE(entity.getComponent<QueryParticle>() == nullptr);
+        counted++;
+    }
+
+};
+
+TEST (ViewTest, TestWithoutAndOptional) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Queries with excluded and optional components" << endl;
+
+    registerComponent<QueryBody>();
+    registerComponent<QueryParticle>(Storing::SPARSE);
+    registerComponent<QueryMovement>();
+    registerComponent<QueryStatic>();
+
+    vector<Entity> entities;
+    for (int i = 0; i < 100; i++) {
+        Entity entity = createEntity();
+        entity.addComponent(QueryBody());
+        if (i % 4 == 0)
+            entity.addComponent(QueryParticle());
+        if (i % 2 == 0)
+            entity.addComponent(QueryMovement{float(i)});
+        entities.push_back(entity);
+    }
+
+    auto bodies = view<QueryBody, Without<QueryParticle>, Optional<QueryMovement>>();
+    ASSERT_EQ(bodies.count(), 75);
+
+    uint32 moving = 0;
+    bodies.each([&](QueryBody& body, QueryMovement* movement) {
+        if (movement != nullptr)
+            moving++;
+    });
+    ASSERT_EQ(moving, 25);
+
+    // membership changes by adding and removing excluded components
+    entities[1].addComponent(QueryParticle());
+    entities[0].deleteComponent<QueryParticle>();
+    entities[4].erase();
+    ASSERT_EQ(bodies.count(), 75);
+
+    auto counting = std::make_shared<CountingSystem>();
+    std::static_pointer_cast<System>(counting)->update(0.0f);
+    ASSERT_EQ(counting->counted, 75);
+
+    uint32 staticAmount = 0;
+    each<QueryBody, Without<QueryStatic>>([&](EntityId entityId, QueryBody& body) { staticAmount++; });
+    ASSERT_EQ(staticAmount, 99);
+
+}
+
+
+struct ChunkBody {
+    int size = 1;
+};
+
+TEST (ViewTest, TestWithoutArchetypes) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Exclude archetype stored components" << endl;
+
+    registerComponent<ChunkBody>(Storing::ARCHETYPE);
+    registerComponent<ChunkVelocity>(Storing::ARCHETYPE);
+
+    for (int i = 0; i < 300; i++) {
+        Entity entity = createEntity();
+        entity.addComponent(ChunkBody());
+        if (i % 3 == 0)
+            entity.addComponent(ChunkVelocity());
+    }
+
+    auto resting = view<ChunkBody, Without<ChunkVelocity>>();
+    ASSERT_EQ(resting.count(), 200);
+
+    auto all = view<ChunkBody, Optional<ChunkVelocity>>();
+    uint32 withVelocity = 0;
+    uint32 amount = 0;
+    all.eachChunk([&](uint32 spanAmount, ChunkBody* bodies, ChunkVelocity* velocities) {
+        amount += spanAmount;
+        if (velocities != nullptr)
+            withVelocity += spanAmount;
+    });
+    ASSERT_EQ(amount, 300);
+    ASSERT_EQ(withVelocity, 100);
+
+}
+
+
+struct MixedBody {
+    int size = 1;
+};
+
+struct MixedMarker {
+    int value = 2;
+};
+
+TEST (ViewTest, TestMixedStorageChunks) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Pass optional components stored outside of archetypes" << endl;
+
+    registerComponent<MixedBody>(Storing::ARCHETYPE);
+    registerComponent<MixedMarker>(Storing::SPARSE);
+
+    for (int i = 0; i < 300; i++) {
+        Entity entity = createEntity();
+        entity.addComponent(MixedBody());
+        if (i % 3 == 0)
+            entity.addComponent(MixedMarker());
+    }
+
+    auto all = view<MixedBody, Optional<MixedMarker>>();
+    uint32 withMarker = 0;
+    uint32 amount = 0;
+    all.eachChunk([&](uint32 spanAmount, MixedBody* bodies, MixedMarker* markers) {
+        amount += spanAmount;
+        if (markers != nullptr) {
+            for (uint32 i = 0; i < spanAmount; i++)
+                ASSERT_EQ(markers[i].value, 2);
+            withMarker += spanAmount;
+        }
+    });
+    ASSERT_EQ(amount, 300);
+    ASSERT_EQ(withMarker, 100);
+
+}
+
+
+struct ThrowingCounter {
+    int visits = 0;
+};
+
+TEST (ViewTest, TestThrowingCallback) {
+
+    EcsManager manager;
+    initTypeManaging(manager);
+
+    cout << "Begin the next pass from the start after a callback threw" << endl;
+
+    registerComponent<ThrowingCounter>(Storing::SPARSE);
+
+    vector<Entity> entities;
+    for (int i = 0; i < 100; i++) {
+        entities.push_back(createEntity());
+        entities.back().addComponent(ThrowingCounter());
+    }
+
+    auto counters = view<ThrowingCounter>();
+    int passed = 0;
+    ASSERT_THROW(counters.each([&](ThrowingCounter& counter) {
+        if (++passed == 10)
+            throw std::runtime_error("stop");
+        counter.visits++;
+    }), std::runtime_error);
+
+    entities[50].erase();
+
+    passed = 0;
+    counters.each([&](ThrowingCounter& counter) {
+        passed++;
+        counter.visits++;
+    });
+    ASSERT_EQ(passed, 99);
+    for (int i = 0; i < 100; i++) {
+        if (i != 50) {
+            ASSERT_GE(entities[i].getComponent<ThrowingCounter>()->visits, 1);
+        }
+    }
+
+}